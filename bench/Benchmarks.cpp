@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Bench.hpp"
+#include "Bitset.hpp"
+#include "Experiments.hpp"
+#include "Factor.hpp"
+#include "Parallel.hpp"
+#include "Primes.hpp"
+#include "Sort.hpp"
+#include "Wheel.hpp"
+#include "Utils.hpp"
+
+#include "sha1.hpp"
+#include "sha512.hpp"
+#include "murmurhash2.hpp"
+
+namespace u = RozeFoundUtils;
+
+static std::vector<uint32_t> random_keys(size_t size) {
+
+	std::mt19937 generator(42);
+	auto keys = std::vector<uint32_t>(size);
+	for (auto& key : keys) key = generator();
+
+	return keys;
+}
+
+// Primes
+
+BENCHMARK(is_prime_loop, { 1000000 }) {
+
+	auto numbers = Range<int>(state.param());
+
+	state.run([&]{
+		int count = 0;
+		for (int i : numbers) count += u::primes::is_prime(i);
+		u::bench::keep(count);
+	}, numbers.size());
+}
+
+BENCHMARK(is_prime_parallel, { 1000000 }, { 1, 2, 4, 8 }) {
+
+	size_t size = state.param(0);
+
+	state.run([&]{
+		std::atomic<int> count = 0;
+		u::parallel_chunks(0, size, [&](size_t begin, size_t end, size_t) {
+			int local = 0;
+			for (size_t i = begin; i < end; i++) local += u::primes::is_prime(i);
+			count += local;
+		}, state.param(1));
+		u::bench::keep(count);
+	}, size);
+}
+
+BENCHMARK(primes_between, { 1000000, 1000000000000 }) {
+
+	uint64_t from = state.param();
+
+	state.run([&]{ u::bench::keep(u::primes::primes_between(from, from + 1000000).size()); }, 1000000);
+}
+
+BENCHMARK(count_primes, { 1 << 16, 1 << 20, 1 << 24 }) {
+	state.run([&]{ u::bench::keep(u::primes::count_primes(state.param())); }, state.param());
+}
+
+BENCHMARK(prime_generator, { 0, 1000000000000 }) {
+
+	uint64_t from = state.param();
+	auto batch = std::vector<uint64_t>(1 << 12);
+
+	state.run([&]{
+		auto generator = u::primes::prime_generator(from, from + 10000000);
+		size_t count = 0;
+		while (size_t n = generator.next_batch(batch)) count += n;
+		u::bench::keep(count);
+	}, 10000000);
+}
+
+BENCHMARK(bitset_count, { 1 << 20, 1 << 27 }) {
+
+	auto bits = u::bitset(state.param(), true);
+	state.run([&]{ u::bench::keep(bits.count()); }, state.param());
+}
+
+BENCHMARK(prime_pi, { 1000000000, 100000000000 }) {
+	state.run([&]{ u::bench::keep(u::primes::prime_pi(state.param())); });
+}
+
+BENCHMARK(factorize_batch, { 1 << 12 }) {
+
+	std::mt19937_64 generator(42);
+	auto values = std::vector<uint64_t>(state.param());
+	for (auto& value : values) value = generator();
+
+	state.run([&]{ u::bench::keep(u::primes::factorize(values)); }, values.size());
+}
+
+// Sorting, every algorithm sorts a fresh copy of the same keys
+
+BENCHMARK(std_sort, { 1 << 16, 1 << 20 }) {
+
+	auto keys = random_keys(state.param()), data = keys;
+
+	state.run([&]{
+		std::copy(keys.begin(), keys.end(), data.begin());
+		std::sort(data.begin(), data.end());
+	}, keys.size());
+}
+
+BENCHMARK(parallel_sort, { 1 << 16, 1 << 20 }) {
+
+	auto keys = random_keys(state.param()), data = keys;
+
+	state.run([&]{
+		std::copy(keys.begin(), keys.end(), data.begin());
+		u::parallel::sort(data, [](uint32_t a, uint32_t b) { return a < b; });
+	}, keys.size());
+}
+
+BENCHMARK(radix_sort, { 1 << 16, 1 << 20 }) {
+
+	auto keys = random_keys(state.param()), data = keys;
+
+	state.run([&]{
+		std::copy(keys.begin(), keys.end(), data.begin());
+		u::radix_sort(data);
+	}, keys.size());
+}
+
+// Hashing
+
+BENCHMARK(sha1, { 1 << 16, 1 << 22 }) {
+
+	auto data = std::string(state.param(), 'x');
+
+	state.run([&]{
+		SHA1 checksum;
+		checksum.update(data);
+		u::bench::keep(checksum.final());
+	}, data.size());
+}
+
+BENCHMARK(sha512, { 1 << 16, 1 << 22 }) {
+	auto data = std::string(state.param(), 'x');
+	state.run([&]{ u::bench::keep(sw::sha512::calculate(data)); }, data.size());
+}
+
+BENCHMARK(murmur2, { 1 << 16, 1 << 22 }) {
+	auto data = std::string(state.param(), 'x');
+	state.run([&]{ u::bench::keep(MurmurHash2(data.data(), int(data.size()), 1)); }, data.size());
+}
+
+// Containers and formatting
+
+BENCHMARK(small_array_sort, { 16, 1024 }) {
+
+	auto keys = random_keys(state.param());
+
+	state.run([&]{
+		auto arr = small_array<uint32_t>(keys.size());
+		std::copy(keys.begin(), keys.end(), arr.begin());
+		std::ranges::sort(arr);
+		u::bench::keep(arr[0]);
+	}, keys.size());
+}
+
+BENCHMARK(join_numbers, { 1 << 16 }) {
+	auto keys = random_keys(state.param());
+	state.run([&]{ u::bench::keep(keys | ext::join); }, keys.size());
+}
@@ -0,0 +1,5 @@
+#include "Bench.hpp"
+
+int main(int argc, char* argv[]) {
+	return RozeFoundUtils::bench::main(argc, argv);
+}
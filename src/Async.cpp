@@ -0,0 +1,231 @@
+#include "Async.hpp"
+#include "Utils.hpp"
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef THIRD_PARTY
+#include <crc32c/crc32c.h>
+#endif
+
+namespace RozeFoundUtils::io {
+
+    namespace detail {
+
+        int open_fallback(const char* path, int flags, unsigned mode) noexcept {
+            int fd = ::open(path, flags, mode);
+            return fd < 0 ? -errno : fd;
+        }
+
+        int read_fallback(int fd, std::span<char> buffer, uint64_t offset) noexcept {
+            auto count = pread(fd, buffer.data(), buffer.size(), off_t(offset));
+            return count < 0 ? -errno : int(count);
+        }
+
+        int write_fallback(int fd, std::span<const char> buffer, uint64_t offset) noexcept {
+            auto count = pwrite(fd, buffer.data(), buffer.size(), off_t(offset));
+            return count < 0 ? -errno : int(count);
+        }
+
+        int close_fallback(int fd) noexcept {
+            return ::close(fd) < 0 ? -errno : 0;
+        }
+    }
+
+    namespace {
+
+        // Status of a process that may exit while it is being read
+        task<std::optional<std::string>> try_read(event_loop& loop, std::filesystem::path path) {
+            try { co_return co_await read(loop, std::move(path)); }
+            catch (const std::system_error&) { co_return std::nullopt; }
+        }
+
+        bool is_number(const std::string& name) {
+            return !name.empty() && name.find_first_not_of("0123456789") == std::string::npos;
+        }
+    }
+
+    event_loop::event_loop(unsigned entries) {
+
+        if (!uring::supported()) return;
+
+        try { m_Ring = std::make_unique<uring>(entries); }
+        catch (const std::system_error&) {}
+
+    }
+
+    io_uring_sqe* event_loop::get_sqe() {
+
+        // A full queue empties as soon as the kernel has been told about it
+        auto* sqe = m_Ring->get_sqe();
+        if (!sqe) {
+            m_Ring->submit(0);
+            sqe = m_Ring->get_sqe();
+        }
+
+        if (!sqe) throw std::runtime_error("io_uring submission queue is full");
+        return sqe;
+
+    }
+
+    void event_loop::poll() {
+
+        m_Ring->submit(0);
+        if (m_Ring->in_flight() == 0) throw std::logic_error("Task is waiting on something the event loop doesn't drive");
+
+        auto collect = [&](uint64_t data, int result) {
+            auto* op = reinterpret_cast<operation_base*>(data);
+            op->result = result;
+            m_Ready.push_back(op->handle);
+        };
+
+        if (m_Ring->reap(collect) == 0) {
+            m_Ring->submit(1);
+            m_Ring->reap(collect);
+        }
+
+        // Resumed coroutines may queue more operations, so resume from a copy
+        auto ready = std::move(m_Ready);
+        m_Ready.clear();
+
+        for (auto handle : ready) handle.resume();
+
+    }
+
+    task<std::string> read(event_loop& loop, std::filesystem::path path) {
+
+        int fd = co_await loop.open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(-fd, std::system_category(), "open " + path.string());
+
+        // /proc and friends report a size of 0, the buffer grows as needed
+        struct stat info;
+        std::size_t expected = fstat(fd, &info) == 0 && info.st_size > 0 ? std::size_t(info.st_size) : 0;
+
+        // One byte over, so the read that sees the end needs no resize
+        auto data = std::string(std::max<std::size_t>(expected + 1, 4096), '\0');
+        std::size_t length = 0;
+
+        while (true) {
+
+            if (length == data.size()) data.resize(data.size() * 2);
+
+            int count = co_await loop.read(fd, std::span(data.data() + length, data.size() - length), length);
+
+            if (count < 0) {
+                co_await loop.close(fd);
+                throw std::system_error(-count, std::system_category(), "read " + path.string());
+            }
+
+            if (count == 0) break;
+            length += std::size_t(count);
+        }
+
+        co_await loop.close(fd);
+
+        data.resize(length);
+        co_return data;
+
+    }
+
+    task<void> write(event_loop& loop, std::filesystem::path path, std::string data) {
+
+        int fd = co_await loop.open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(-fd, std::system_category(), "open " + path.string());
+
+        for (std::size_t written = 0; written < data.size(); ) {
+
+            int count = co_await loop.write(fd, std::span<const char>(data.data() + written, data.size() - written), written);
+
+            if (count <= 0) {
+                co_await loop.close(fd);
+                throw std::system_error(count < 0 ? -count : EIO, std::system_category(), "write " + path.string());
+            }
+
+            written += std::size_t(count);
+        }
+
+        int result = co_await loop.close(fd);
+        if (result < 0) throw std::system_error(-result, std::system_category(), "close " + path.string());
+
+    }
+
+    task<std::optional<std::string>> read_from_file(event_loop& loop, std::filesystem::path filepath) {
+
+        try { co_return co_await read(loop, std::move(filepath)); }
+        catch (const std::system_error&) { throw std::runtime_error("File is not found"); }
+
+    }
+
+    task<void> write_to_file(event_loop& loop, std::string string, std::filesystem::path filepath) {
+        co_await write(loop, std::move(filepath), std::move(string));
+    }
+
+    task<uint32_t> get_process_id(event_loop& loop, std::string process_name) {
+
+        std::vector<std::filesystem::path> statuses;
+
+        for (const auto& entry : std::filesystem::directory_iterator("/proc/"))
+            if (is_number(entry.path().filename().string()))
+                statuses.push_back(entry.path() / "status");
+
+        // Waves keep the number of open descriptors bounded
+        constexpr std::size_t wave = 64;
+
+        for (std::size_t first = 0; first < statuses.size(); first += wave) {
+
+            std::vector<task<std::optional<std::string>>> reads;
+            for (std::size_t i = first; i < std::min(first + wave, statuses.size()); i++)
+                reads.push_back(try_read(loop, statuses[i]));
+
+            auto contents = co_await when_all(std::move(reads));
+
+            for (std::size_t i = 0; i < contents.size(); i++)
+                if (contents[i] && contents[i]->find(process_name) != std::string::npos)
+                    co_return uint32_t(std::stoul(statuses[first + i].parent_path().filename().string()));
+        }
+
+        co_return 0xDEADC0DE;
+
+    }
+
+    task<std::ptrdiff_t> get_module_base(event_loop& loop, uint32_t process_id, std::string module) {
+
+        auto maps_path = "/proc/" + std::to_string(process_id) + "/maps";
+        if (process_id == 0) maps_path = "/proc/self/maps";
+
+        auto maps = co_await read_from_file(loop, maps_path);
+
+        co_return find_module_base(*maps, module);
+
+    }
+
+#ifdef THIRD_PARTY
+
+    task<uint32_t> crc32(event_loop& loop, std::filesystem::path path) {
+
+        int fd = co_await loop.open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(-fd, std::system_category(), "open " + path.string());
+
+        uint32_t result = 0;
+        auto buffer = std::vector<char>(1 << 16);
+
+        for (uint64_t offset = 0; ; ) {
+
+            int count = co_await loop.read(fd, buffer, offset);
+            if (count <= 0) break;
+
+            result = crc32c::Extend(result, reinterpret_cast<const uint8_t*>(buffer.data()), std::size_t(count));
+            offset += uint64_t(count);
+        }
+
+        co_await loop.close(fd);
+        co_return result;
+
+    }
+
+#endif
+}
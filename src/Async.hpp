@@ -0,0 +1,399 @@
+#pragma once
+
+#include <coroutine>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Uring.hpp"
+
+#include <fcntl.h>
+
+namespace RozeFoundUtils {
+
+	namespace io {
+
+		template<typename T = void> class task;
+
+		namespace detail {
+
+			struct promise_base {
+
+				std::coroutine_handle<> continuation;
+				std::exception_ptr error;
+
+				// Finishing hands control straight back to whoever awaited the task
+				struct final_awaiter {
+					bool await_ready() const noexcept { return false; }
+					template<typename P> std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) const noexcept {
+						auto next = handle.promise().continuation;
+						return next ? next : std::noop_coroutine();
+					}
+					void await_resume() const noexcept {}
+				};
+
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+				final_awaiter final_suspend() const noexcept { return {}; }
+				void unhandled_exception() noexcept { error = std::current_exception(); }
+			};
+
+			template<typename T> struct promise : promise_base {
+
+				std::optional<T> value;
+
+				void return_value(T result) { value.emplace(std::move(result)); }
+
+				T result() {
+					if (error) std::rethrow_exception(error);
+					return std::move(*value);
+				}
+			};
+
+			template<> struct promise<void> : promise_base {
+
+				void return_void() const noexcept {}
+
+				void result() const {
+					if (error) std::rethrow_exception(error);
+				}
+			};
+		}
+
+		// Lazily started coroutine, runs once awaited and resumes its awaiter when done
+
+		template<typename T> class task {
+
+		public:
+
+			struct promise_type : detail::promise<T> {
+				task get_return_object() noexcept { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			};
+
+			using handle_type = std::coroutine_handle<promise_type>;
+
+			// Constructors
+
+			task(task&& other) noexcept : m_Handle(std::exchange(other.m_Handle, {})) {}
+
+			task& operator=(task&& other) noexcept {
+				if (this != &other) {
+					if (m_Handle) m_Handle.destroy();
+					m_Handle = std::exchange(other.m_Handle, {});
+				}
+				return *this;
+			}
+
+			~task() { if (m_Handle) m_Handle.destroy(); }
+
+			// Methods
+
+			bool done() const noexcept { return !m_Handle || m_Handle.done(); }
+
+			auto operator co_await() noexcept {
+
+				struct awaiter {
+
+					handle_type handle;
+
+					bool await_ready() const noexcept { return !handle || handle.done(); }
+
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+						handle.promise().continuation = awaiting;
+						return handle;
+					}
+
+					T await_resume() const { return handle.promise().result(); }
+				};
+
+				return awaiter { m_Handle };
+			}
+
+		private:
+
+			explicit task(handle_type handle) noexcept : m_Handle(handle) {}
+
+			friend class event_loop;
+
+			// Local variables
+
+			handle_type m_Handle;
+		};
+
+		// Single threaded loop driving tasks and their I/O. Operations go through
+		// io_uring where the kernel allows it, otherwise they complete synchronously
+
+		class event_loop {
+
+		public:
+
+			struct operation_base {
+				int result = 0;
+				std::coroutine_handle<> handle;
+			};
+
+			// Awaitable result of a single operation, the negated errno on failure
+
+			template<typename Prepare, typename Fallback> struct operation : operation_base {
+
+				operation(event_loop& loop, Prepare prepare, Fallback fallback) : loop(loop), prepare(prepare), fallback(fallback) {}
+
+				bool await_ready() {
+					if (loop.m_Ring) return false;
+					result = fallback();
+					return true;
+				}
+
+				void await_suspend(std::coroutine_handle<> awaiting) {
+					handle = awaiting;
+					auto* sqe = loop.get_sqe();
+					prepare(sqe);
+					sqe->user_data = reinterpret_cast<uint64_t>(static_cast<operation_base*>(this));
+				}
+
+				int await_resume() const noexcept { return result; }
+
+				event_loop& loop;
+				Prepare prepare;
+				Fallback fallback;
+			};
+
+			// Constructors
+
+			explicit event_loop(unsigned entries = 256);
+
+			// Methods
+
+			// Runs the task and everything it awaits to completion
+			template<typename T> T run(task<T> root) {
+				root.m_Handle.resume();
+				while (!root.done()) poll();
+				return root.m_Handle.promise().result();
+			}
+
+			bool uses_uring() const noexcept { return m_Ring != nullptr; }
+
+			auto open(const std::filesystem::path& path, int flags, unsigned mode = 0644);
+			auto read(int fd, std::span<char> buffer, uint64_t offset);
+			auto write(int fd, std::span<const char> buffer, uint64_t offset);
+			auto close(int fd);
+
+		private:
+
+			// Local methods
+
+			io_uring_sqe* get_sqe();
+
+			// Submits what was prepared, waits for at least one completion and resumes its coroutines
+			void poll();
+
+			// Local variables
+
+			std::unique_ptr<uring> m_Ring;
+			std::vector<std::coroutine_handle<>> m_Ready;
+		};
+
+		namespace detail {
+			int open_fallback(const char* path, int flags, unsigned mode) noexcept;
+			int read_fallback(int fd, std::span<char> buffer, uint64_t offset) noexcept;
+			int write_fallback(int fd, std::span<const char> buffer, uint64_t offset) noexcept;
+			int close_fallback(int fd) noexcept;
+		}
+
+		inline auto event_loop::open(const std::filesystem::path& path, int flags, unsigned mode) {
+			auto prepare = [&path, flags, mode](io_uring_sqe* sqe) {
+				sqe->opcode = IORING_OP_OPENAT;
+				sqe->fd = AT_FDCWD;
+				sqe->addr = reinterpret_cast<uint64_t>(path.c_str());
+				sqe->open_flags = unsigned(flags);
+				sqe->len = mode;
+			};
+			auto fallback = [&path, flags, mode] { return detail::open_fallback(path.c_str(), flags, mode); };
+			return operation(*this, prepare, fallback);
+		}
+
+		inline auto event_loop::read(int fd, std::span<char> buffer, uint64_t offset) {
+			auto prepare = [=](io_uring_sqe* sqe) {
+				sqe->opcode = IORING_OP_READ;
+				sqe->fd = fd;
+				sqe->addr = reinterpret_cast<uint64_t>(buffer.data());
+				sqe->len = unsigned(buffer.size());
+				sqe->off = offset;
+			};
+			auto fallback = [=] { return detail::read_fallback(fd, buffer, offset); };
+			return operation(*this, prepare, fallback);
+		}
+
+		inline auto event_loop::write(int fd, std::span<const char> buffer, uint64_t offset) {
+			auto prepare = [=](io_uring_sqe* sqe) {
+				sqe->opcode = IORING_OP_WRITE;
+				sqe->fd = fd;
+				sqe->addr = reinterpret_cast<uint64_t>(buffer.data());
+				sqe->len = unsigned(buffer.size());
+				sqe->off = offset;
+			};
+			auto fallback = [=] { return detail::write_fallback(fd, buffer, offset); };
+			return operation(*this, prepare, fallback);
+		}
+
+		inline auto event_loop::close(int fd) {
+			auto prepare = [=](io_uring_sqe* sqe) {
+				sqe->opcode = IORING_OP_CLOSE;
+				sqe->fd = fd;
+			};
+			auto fallback = [=] { return detail::close_fallback(fd); };
+			return operation(*this, prepare, fallback);
+		}
+
+		namespace detail {
+
+			struct join_state {
+				std::size_t remaining;
+				std::coroutine_handle<> parent;
+				std::exception_ptr error;
+			};
+
+			// Wraps one child of when_all, the last to finish resumes the parent
+
+			class join_task {
+
+			public:
+
+				struct promise_type {
+
+					join_state* state = nullptr;
+
+					struct final_awaiter {
+						bool await_ready() const noexcept { return false; }
+						std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+							auto* state = handle.promise().state;
+							return --state->remaining == 0 ? state->parent : std::noop_coroutine();
+						}
+						void await_resume() const noexcept {}
+					};
+
+					join_task get_return_object() noexcept { return join_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+					std::suspend_always initial_suspend() const noexcept { return {}; }
+					final_awaiter final_suspend() const noexcept { return {}; }
+					void return_void() const noexcept {}
+					void unhandled_exception() noexcept { if (!state->error) state->error = std::current_exception(); }
+				};
+
+				join_task(join_task&& other) noexcept : m_Handle(std::exchange(other.m_Handle, {})) {}
+				~join_task() { if (m_Handle) m_Handle.destroy(); }
+
+				void start(join_state& state) {
+					m_Handle.promise().state = &state;
+					m_Handle.resume();
+				}
+
+			private:
+
+				explicit join_task(std::coroutine_handle<promise_type> handle) noexcept : m_Handle(handle) {}
+
+				std::coroutine_handle<promise_type> m_Handle;
+			};
+
+			template<typename T> join_task join_one(task<T> child, std::optional<T>* out) {
+				out->emplace(co_await child);
+			}
+
+			inline join_task join_one(task<void> child) {
+				co_await child;
+			}
+
+			// Starts every child and suspends until the last one is done, unless they all finished on the spot
+			struct join_awaiter {
+
+				join_state& state;
+				std::span<join_task> joins;
+
+				bool await_ready() const noexcept { return joins.empty(); }
+
+				bool await_suspend(std::coroutine_handle<> parent) {
+					state.parent = parent;
+					for (auto& join : joins) join.start(state);
+					return --state.remaining != 0;
+				}
+
+				void await_resume() const {
+					if (state.error) std::rethrow_exception(state.error);
+				}
+			};
+
+			template<typename T> using all_t = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+		}
+
+		// Runs the tasks concurrently, results come back in the order the tasks were given.
+		// The first exception thrown by any of them is rethrown once all have finished
+
+		template<typename T> task<detail::all_t<T>> when_all(std::vector<task<T>> tasks) {
+
+			detail::join_state state { tasks.size() + 1 };
+			std::vector<detail::join_task> joins;
+			joins.reserve(tasks.size());
+
+			if constexpr (std::is_void_v<T>) {
+
+				for (auto& child : tasks) joins.push_back(detail::join_one(std::move(child)));
+				co_await detail::join_awaiter { state, joins };
+
+			} else {
+
+				auto results = std::vector<std::optional<T>>(tasks.size());
+				for (std::size_t i = 0; i < tasks.size(); i++) joins.push_back(detail::join_one(std::move(tasks[i]), &results[i]));
+
+				co_await detail::join_awaiter { state, joins };
+
+				std::vector<T> values;
+				values.reserve(results.size());
+				for (auto& result : results) values.push_back(std::move(*result));
+
+				co_return values;
+			}
+		}
+
+		template<typename... Ts> requires (!std::is_void_v<Ts> && ...)
+		task<std::tuple<Ts...>> when_all(task<Ts>... tasks) {
+
+			detail::join_state state { sizeof...(Ts) + 1 };
+			std::tuple<std::optional<Ts>...> results;
+
+			auto joins = [&]<std::size_t... I>(std::index_sequence<I...>) {
+				return std::array<detail::join_task, sizeof...(Ts)> { detail::join_one(std::move(tasks), &std::get<I>(results))... };
+			}(std::index_sequence_for<Ts...>());
+
+			co_await detail::join_awaiter { state, joins };
+
+			co_return std::apply([](auto&... result) { return std::tuple<Ts...>(std::move(*result)...); }, results);
+		}
+
+		// Whole contents of a file, throws std::system_error when it can't be opened or read
+		task<std::string> read(event_loop& loop, std::filesystem::path path);
+
+		// Replaces the file with data
+		task<void> write(event_loop& loop, std::filesystem::path path, std::string data);
+
+		// Awaitable versions of the blocking helpers in Utils.hpp
+
+		task<std::optional<std::string>> read_from_file(event_loop& loop, std::filesystem::path filepath);
+		task<void> write_to_file(event_loop& loop, std::string string, std::filesystem::path filepath);
+
+		// Reads the status of every process concurrently
+		task<uint32_t> get_process_id(event_loop& loop, std::string process_name);
+		task<std::ptrdiff_t> get_module_base(event_loop& loop, uint32_t process_id = 0, std::string module = "");
+
+#ifdef THIRD_PARTY
+		task<uint32_t> crc32(event_loop& loop, std::filesystem::path path);
+#endif
+	}
+}
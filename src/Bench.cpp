@@ -0,0 +1,258 @@
+#include "Bench.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fmt/format.h>
+
+namespace RozeFoundUtils::bench {
+
+    namespace {
+
+        struct entry {
+            std::string name;
+            std::vector<std::vector<int64_t>> axes;
+            function body;
+        };
+
+        std::vector<entry>& registry() {
+            static std::vector<entry> entries;
+            return entries;
+        }
+
+        // Every combination of one value per axis, the last axis varying fastest
+        std::vector<std::vector<int64_t>> combinations(const std::vector<std::vector<int64_t>>& axes) {
+
+            auto result = std::vector<std::vector<int64_t>>{ {} };
+
+            for (const auto& axis : axes) {
+                std::vector<std::vector<int64_t>> next;
+                for (const auto& prefix : result)
+                    for (auto value : axis) {
+                        next.push_back(prefix);
+                        next.back().push_back(value);
+                    }
+                result = std::move(next);
+            }
+
+            return result;
+        }
+
+        // Value of "key": in a line written by write_json
+        std::string_view field(std::string_view line, std::string_view key) {
+
+            auto pattern = fmt::format("\"{}\":", key);
+            auto at = line.find(pattern);
+            if (at == std::string_view::npos) return {};
+
+            line.remove_prefix(at + pattern.size());
+            if (line.starts_with('"')) return line.substr(1, line.find('"', 1) - 1);
+
+            return line.substr(0, line.find_first_of(",}"));
+        }
+
+        template<typename T> T number(std::string_view text) {
+            T value = {};
+            std::from_chars(text.data(), text.data() + text.size(), value);
+            return value;
+        }
+
+        // Command line values have to be a number in full, anything else is a typo
+        template<typename T> std::optional<T> exact_number(std::string_view text) {
+            T value = {};
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc() || end != text.data() + text.size()) return std::nullopt;
+            return value;
+        }
+    }
+
+    void state::run(const std::function<void()>& body, std::size_t elements) {
+
+        SCOPED_ZONE("benchmark");
+
+        // Warm up caches, page in the data and let the clock ramp
+        body();
+
+        std::vector<double> samples;
+        auto started = std::chrono::steady_clock::now();
+
+        while (samples.size() < 3 || std::chrono::steady_clock::now() - started < m_MinTime) {
+            auto begin = std::chrono::steady_clock::now();
+            body();
+            samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        m_Result = result {
+            .iterations = samples.size(),
+            .median_ns = samples[samples.size() / 2],
+            .min_ns = samples.front(),
+            .elements = elements,
+        };
+
+    }
+
+    bool add(std::string_view name, std::vector<std::vector<int64_t>> axes, function body) {
+        registry().push_back({ std::string(name), std::move(axes), body });
+        return true;
+    }
+
+    std::vector<result> run_all(const options& options) {
+
+        std::vector<result> results;
+
+        for (const auto& entry : registry()) {
+
+            if (entry.name.find(options.filter) == std::string::npos) continue;
+
+            for (auto& params : combinations(entry.axes)) {
+
+                auto name = entry.name;
+                for (auto param : params) name += fmt::format("/{}", param);
+
+                state state(params, options.min_time);
+                entry.body(state);
+
+                if (!state.measured()) {
+                    std::cout << name << ": never called state.run" << std::endl;
+                    continue;
+                }
+
+                auto& result = results.emplace_back(*state.measured());
+                result.name = std::move(name);
+
+                std::cout << fmt::format("{:<40} {:>14.0f}ns {:>14.0f}ns min {:>8} runs", result.name, result.median_ns, result.min_ns, result.iterations);
+                if (result.elements) std::cout << fmt::format(" {:>10.3f}ns/element", result.ns_per_element());
+                std::cout << std::endl;
+            }
+        }
+
+        return results;
+
+    }
+
+    void write_json(const std::filesystem::path& path, const std::vector<result>& results) {
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file) throw std::runtime_error("Can't open benchmark results for writing");
+
+        // One result per line keeps read_json trivial and diffs readable
+        file << "[\n";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const auto& r = results[i];
+            file << fmt::format("{{\"name\":\"{}\",\"iterations\":{},\"median_ns\":{:.1f},\"min_ns\":{:.1f},\"elements\":{}}}{}\n",
+                r.name, r.iterations, r.median_ns, r.min_ns, r.elements, i + 1 < results.size() ? "," : "");
+        }
+        file << "]\n";
+
+    }
+
+    std::vector<result> read_json(const std::filesystem::path& path) {
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file) throw std::runtime_error("Benchmark baseline is not found");
+
+        std::vector<result> results;
+
+        for (std::string line; std::getline(file, line); ) {
+
+            auto name = field(line, "name");
+            if (name.empty()) continue;
+
+            results.push_back({
+                .name = std::string(name),
+                .iterations = number<std::size_t>(field(line, "iterations")),
+                .median_ns = number<double>(field(line, "median_ns")),
+                .min_ns = number<double>(field(line, "min_ns")),
+                .elements = number<std::size_t>(field(line, "elements")),
+            });
+        }
+
+        return results;
+
+    }
+
+    std::size_t compare(const std::vector<result>& results, const std::vector<result>& baseline, double threshold) {
+
+        std::map<std::string_view, const result*> previous;
+        for (const auto& r : baseline) previous[r.name] = &r;
+
+        std::size_t regressions = 0;
+
+        for (const auto& r : results) {
+
+            auto it = previous.find(r.name);
+            if (it == previous.end() || it->second->median_ns <= 0) {
+                std::cout << fmt::format("{:<40} new", r.name) << std::endl;
+                continue;
+            }
+
+            double change = r.median_ns / it->second->median_ns - 1;
+            bool regressed = change > threshold;
+            regressions += regressed;
+
+            std::cout << fmt::format("{:<40} {:>+8.1f}%{}", r.name, change * 100, regressed ? "  REGRESSION" : "") << std::endl;
+        }
+
+        return regressions;
+
+    }
+
+    int main(int argc, char** argv) {
+
+        options options;
+
+        for (int i = 1; i < argc; i++) {
+
+            std::string_view arg = argv[i];
+            if (i + 1 == argc) { std::cerr << "Missing value for " << arg << std::endl; return 2; }
+
+            std::string_view value = argv[++i];
+
+            if (arg == "--filter") options.filter = value;
+            else if (arg == "--json") options.json = value;
+            else if (arg == "--baseline") options.baseline = value;
+            else if (arg == "--threshold" || arg == "--min-time") {
+
+                auto parsed = exact_number<double>(value);
+                if (!parsed || !(*parsed >= 0)) {
+                    std::cerr << "Invalid value " << value << " for " << arg << ", expected a non-negative number" << std::endl;
+                    return 2;
+                }
+
+                if (arg == "--threshold") options.threshold = *parsed;
+                else options.min_time = std::chrono::duration<double>(*parsed);
+            }
+            else { std::cerr << "Unknown option " << arg << std::endl; return 2; }
+        }
+
+        // A gate that quietly compares against nothing isn't one, so fail before spending the time
+        if (options.baseline && !std::filesystem::exists(*options.baseline)) {
+            std::cerr << "Baseline " << options.baseline->string() << " is not found, record one first with --json "
+                << options.baseline->string() << " (or `cmake --build . --target bench-baseline`)" << std::endl;
+            return 2;
+        }
+
+        auto results = run_all(options);
+
+        if (options.json) write_json(*options.json, results);
+
+        if (!options.baseline) return 0;
+
+        std::cout << "\nCompared with " << options.baseline->string() << ", threshold " << options.threshold * 100 << "%" << std::endl;
+        auto regressions = compare(results, read_json(*options.baseline), options.threshold);
+
+        if (regressions) std::cout << regressions << " benchmark(s) regressed" << std::endl;
+        return regressions ? 1 : 0;
+
+    }
+}
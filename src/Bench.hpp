@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Trace.hpp"
+
+// Registers a benchmark, every argument after the name is one braced axis of
+// parameters and the body runs once per combination of them:
+//
+//	BENCHMARK(radix_sort, {1 << 16, 1 << 20}, {1, 4}) {
+//		auto data = make_data(state.param(0));
+//		state.run([&]{ sort(data, state.param(1)); }, data.size());
+//	}
+
+#define BENCHMARK(name, ...) \
+	static void ROZE_CONCAT(benchmark_, name)(::RozeFoundUtils::bench::state&); \
+	static const bool ROZE_CONCAT(benchmark_registered_, name) = \
+		::RozeFoundUtils::bench::add(#name, { __VA_ARGS__ }, ROZE_CONCAT(benchmark_, name)); \
+	static void ROZE_CONCAT(benchmark_, name)([[maybe_unused]] ::RozeFoundUtils::bench::state& state)
+
+namespace RozeFoundUtils {
+
+	namespace bench {
+
+		struct result {
+			std::string name;
+			std::size_t iterations = 0;
+			double median_ns = 0, min_ns = 0;
+			std::size_t elements = 0;
+
+			double ns_per_element() const noexcept { return elements ? median_ns / double(elements) : 0; }
+		};
+
+		class state {
+
+		public:
+
+			// Constructors
+
+			state(std::vector<int64_t> params, std::chrono::duration<double> min_time) : m_Params(std::move(params)), m_MinTime(min_time) {}
+
+			// Methods
+
+			int64_t param(std::size_t axis = 0) const { return m_Params.at(axis); }
+			const std::vector<int64_t>& params() const noexcept { return m_Params; }
+
+			// Times body until min_time has passed and at least three runs were made,
+			// only body is measured so setup goes before the call
+			void run(const std::function<void()>& body, std::size_t elements = 0);
+
+			const std::optional<result>& measured() const noexcept { return m_Result; }
+
+		private:
+
+			// Local variables
+
+			std::vector<int64_t> m_Params;
+			std::chrono::duration<double> m_MinTime;
+			std::optional<result> m_Result;
+		};
+
+		using function = void(*)(state&);
+
+		bool add(std::string_view name, std::vector<std::vector<int64_t>> axes, function body);
+
+		// Stops the compiler from discarding a computed value
+		template<typename T> inline void keep(const T& value) {
+			asm volatile("" : : "g"(&value) : "memory");
+		}
+
+		struct options {
+			std::string filter;
+			std::optional<std::filesystem::path> json;
+			std::optional<std::filesystem::path> baseline;
+			double threshold = 0.10;
+			std::chrono::duration<double> min_time = std::chrono::milliseconds(200);
+		};
+
+		// Runs every registered benchmark whose name contains the filter
+		std::vector<result> run_all(const options& options);
+
+		void write_json(const std::filesystem::path& path, const std::vector<result>& results);
+
+		// Reads back files written by write_json
+		std::vector<result> read_json(const std::filesystem::path& path);
+
+		// Prints every result next to its baseline, returns how many got slower than the threshold allows
+		std::size_t compare(const std::vector<result>& results, const std::vector<result>& baseline, double threshold);
+
+		// Entry point of the benchmark runner:
+		// [--filter text] [--json path] [--baseline path] [--threshold 0.1] [--min-time seconds]
+		// A --baseline that doesn't exist is an error, write one with --json first
+		int main(int argc, char** argv);
+	}
+}
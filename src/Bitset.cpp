@@ -0,0 +1,30 @@
+#include "Bitset.hpp"
+
+// Without -mpopcnt std::popcount is a dozen shifts and masks, a POPCNT clone
+// is picked at load time on CPUs that have the instruction
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define POPCOUNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#else
+#define POPCOUNT_CLONES
+#endif
+
+namespace RozeFoundUtils::detail {
+
+    POPCOUNT_CLONES std::size_t popcount(const uint64_t* words, std::size_t count) noexcept {
+
+        // Four accumulators so the adds don't wait on each other
+        std::size_t a = 0, b = 0, c = 0, d = 0, i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            a += std::popcount(words[i]);
+            b += std::popcount(words[i + 1]);
+            c += std::popcount(words[i + 2]);
+            d += std::popcount(words[i + 3]);
+        }
+
+        for (; i < count; i++) a += std::popcount(words[i]);
+
+        return a + b + c + d;
+
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace RozeFoundUtils {
+
+	namespace detail {
+
+		// Set bits in words, built for POPCNT where the CPU has it whatever the compile flags
+		std::size_t popcount(const uint64_t* words, std::size_t count) noexcept;
+	}
+
+	// Packed bits, 64 to a word, with the size fixed when it is built. Everything works
+	// a word at a time, bits past size() are always clear so whole words can be counted
+
+	class bitset {
+
+	public:
+
+		// Constructors
+
+		constexpr bitset() = default;
+		constexpr explicit bitset(std::size_t size, bool value = false) { assign(size, value); }
+
+		// Methods
+
+		constexpr std::size_t size() const noexcept { return m_Size; }
+		constexpr std::span<const uint64_t> words() const noexcept { return m_Words; }
+
+		// Resizes and sets every bit to value, keeps the storage it already has
+		constexpr void assign(std::size_t size, bool value) {
+			m_Size = size;
+			m_Words.assign((size + 63) / 64, value ? ~uint64_t(0) : 0);
+			trim();
+		}
+
+		// Fills the words with pattern over and over, e.g. a presieved wheel.
+		// An empty pattern has nothing to repeat and leaves the bits as they are
+		constexpr void assign_pattern(std::span<const uint64_t> pattern) {
+			if (pattern.empty()) return;
+			for (std::size_t word = 0; word < m_Words.size(); word++)
+				m_Words[word] = pattern[word % pattern.size()];
+			trim();
+		}
+
+		constexpr bool test(std::size_t i) const noexcept { return m_Words[i / 64] >> (i % 64) & 1; }
+		constexpr void set(std::size_t i) noexcept { m_Words[i / 64] |= uint64_t(1) << (i % 64); }
+		constexpr void reset(std::size_t i) noexcept { m_Words[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+
+		// Every step-th bit from first on, the marking loop of a sieve
+		constexpr void set_stride(std::size_t first, std::size_t step) noexcept {
+			for (std::size_t i = first; i < m_Size; i += step)
+				m_Words[i / 64] |= uint64_t(1) << (i % 64);
+		}
+
+		constexpr void reset_stride(std::size_t first, std::size_t step) noexcept {
+			for (std::size_t i = first; i < m_Size; i += step)
+				m_Words[i / 64] &= ~(uint64_t(1) << (i % 64));
+		}
+
+		constexpr std::size_t count() const noexcept { return count_words(m_Words.size()); }
+
+		// Set bits before i
+		constexpr std::size_t rank(std::size_t i) const noexcept {
+			i = std::min(i, m_Size);
+			std::size_t result = count_words(i / 64);
+			if (i % 64) result += std::popcount(m_Words[i / 64] & ((uint64_t(1) << (i % 64)) - 1));
+			return result;
+		}
+
+		// Position of the set bit with rank k, size() when there are no more than k
+		constexpr std::size_t select(std::size_t k) const noexcept {
+
+			for (std::size_t word = 0; word < m_Words.size(); word++) {
+
+				auto bits = m_Words[word];
+				auto count = std::size_t(std::popcount(bits));
+
+				if (k >= count) {
+					k -= count;
+					continue;
+				}
+
+				for (; k > 0; k--) bits &= bits - 1;
+				return word * 64 + std::countr_zero(bits);
+			}
+
+			return m_Size;
+		}
+
+	private:
+
+		// Local methods
+
+		constexpr void trim() noexcept {
+			if (m_Size % 64) m_Words.back() &= (uint64_t(1) << (m_Size % 64)) - 1;
+		}
+
+		constexpr std::size_t count_words(std::size_t words) const noexcept {
+
+			if (!std::is_constant_evaluated()) return detail::popcount(m_Words.data(), words);
+
+			std::size_t result = 0;
+			for (std::size_t word = 0; word < words; word++) result += std::popcount(m_Words[word]);
+			return result;
+		}
+
+		// Local variables
+
+		std::vector<uint64_t> m_Words;
+		std::size_t m_Size = 0;
+	};
+}
@@ -2,23 +2,37 @@
 
 #include <iterator>
 #include <algorithm>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Memory.hpp"
 
 namespace ns {
 
-	template<typename container> struct iterator {
+	template<typename container, bool is_const = false> struct iterator {
 
 		using difference_type = std::ptrdiff_t;
 
 		using value_type = typename container::value_type;
-		using pointer = value_type*;
-		using reference = value_type&;
+		using element_type = std::conditional_t<is_const, const value_type, value_type>;
+		using pointer = element_type*;
+		using reference = element_type&;
 
-		using iterator_tag = std::random_access_iterator_tag;
+		using iterator_category = std::random_access_iterator_tag;
 		using iterator_concept = std::contiguous_iterator_tag;
 
 		iterator() = default;
 		explicit constexpr iterator(pointer Ptr) : m_Ptr(Ptr) {}
 
+		// Mutable iterators convert to const ones
+		template<bool other_const> requires (is_const && !other_const)
+		constexpr iterator(const iterator<container, other_const>& other) noexcept : m_Ptr(other.operator->()) {}
+
 		constexpr auto& operator++() noexcept { ++m_Ptr; return *this; }
 		constexpr auto operator++(int) noexcept { auto Tmp = *this; ++* this; return Tmp; }
 
@@ -30,12 +44,12 @@ namespace ns {
 
 		friend constexpr auto operator+(const ptrdiff_t offset, iterator It) noexcept { It += offset; return It; }
 		[[nodiscard]] constexpr auto operator+(const ptrdiff_t offset) const noexcept { auto Tmp = *this; return Tmp += offset; }
-		friend constexpr auto operator-(const ptrdiff_t offset, iterator It) noexcept { It -= offset; return It; }
 		[[nodiscard]] constexpr auto operator-(const ptrdiff_t offset) const noexcept { auto Tmp = *this; return Tmp -= offset; }
 
 		friend constexpr ptrdiff_t operator-(iterator lhs, iterator rhs) noexcept { return lhs.m_Ptr - rhs.m_Ptr; }
 
-		constexpr auto operator<=>(iterator const&) const = default;
+		friend constexpr bool operator==(iterator lhs, iterator rhs) noexcept { return lhs.m_Ptr == rhs.m_Ptr; }
+		friend constexpr auto operator<=>(iterator lhs, iterator rhs) noexcept { return lhs.m_Ptr <=> rhs.m_Ptr; }
 
 		[[nodiscard]] constexpr reference operator*() const noexcept { return *operator->(); }
 		[[nodiscard]] constexpr reference operator[](const ptrdiff_t offset) const noexcept { return *(*this + offset); };
@@ -43,34 +57,115 @@ namespace ns {
 
 	private:
 
-		pointer m_Ptr;
+		pointer m_Ptr = nullptr;
 	};
+
+	template<typename container> using const_iterator = iterator<container, true>;
 }
 
-template<typename T = int> class array {
+template<typename T = int, typename Allocator = std::allocator<T>> class array {
+
+	using traits = std::allocator_traits<Allocator>;
+
+	// Trivial elements are left uninitialised like new T[size] does, everything else is value-initialised
+	static constexpr bool skip_construction = std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>;
 
 public:
 
 	using value_type = T;
-	using iterator = ns::iterator<array<T>>;
+	using allocator_type = Allocator;
+	using iterator = ns::iterator<array>;
+	using const_iterator = ns::const_iterator<array>;
 	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
 public:
 
 	// Constructors
 
-	array(size_t size) : m_Data(new T[size]), m_Size(size) {}
-	array(std::initializer_list<T> list) : m_Size(list.size()), m_Data(new T[m_Size]) {
-		std::copy(list.begin(), list.end(), m_Data);
+	explicit array(const std::type_identity_t<Allocator>& allocator) noexcept : m_Allocator(allocator) {}
+	array(size_t size, const Allocator& allocator = Allocator()) : m_Allocator(allocator) {
+		allocate(size);
+		if constexpr (!skip_construction) construct_with([&](T* p) { traits::construct(m_Allocator, p); });
+	}
+	array(size_t size, const T& value, const Allocator& allocator = Allocator()) : m_Allocator(allocator) {
+		allocate(size);
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, value); });
+	}
+	array(std::initializer_list<T> list, const Allocator& allocator = Allocator()) : m_Allocator(allocator) {
+		allocate(list.size());
+		auto it = list.begin();
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, *it++); });
+	}
+
+	array(const array& other) : array(other, traits::select_on_container_copy_construction(other.m_Allocator)) {}
+	array(const array& other, const Allocator& allocator) : m_Allocator(allocator) { copy_from(other); }
+
+	array(array&& other) noexcept : m_Allocator(std::move(other.m_Allocator)),
+		m_Size(std::exchange(other.m_Size, 0)), m_Data(std::exchange(other.m_Data, nullptr)) {}
+
+	array(array&& other, const Allocator& allocator) : m_Allocator(allocator) {
+		if (m_Allocator == other.m_Allocator) {
+			m_Size = std::exchange(other.m_Size, 0);
+			m_Data = std::exchange(other.m_Data, nullptr);
+		} else {
+			allocate(other.m_Size);
+			auto source = other.m_Data;
+			construct_with([&](T* p) { traits::construct(m_Allocator, p, std::move(*source++)); });
+		}
+	}
+
+	~array() { reset(); }
+
+	// Assignment
+
+	array& operator=(const array& other) {
+
+		if (this == &other) return *this;
+
+		reset();
+		if constexpr (traits::propagate_on_container_copy_assignment::value)
+			m_Allocator = other.m_Allocator;
+		copy_from(other);
+
+		return *this;
+	}
+
+	array& operator=(array&& other) noexcept(traits::propagate_on_container_move_assignment::value || traits::is_always_equal::value) {
+
+		if (this == &other) return *this;
+
+		reset();
+
+		if constexpr (traits::propagate_on_container_move_assignment::value)
+			m_Allocator = std::move(other.m_Allocator);
+
+		if (traits::propagate_on_container_move_assignment::value || m_Allocator == other.m_Allocator) {
+			m_Size = std::exchange(other.m_Size, 0);
+			m_Data = std::exchange(other.m_Data, nullptr);
+		} else {
+			allocate(other.m_Size);
+			auto source = other.m_Data;
+			construct_with([&](T* p) { traits::construct(m_Allocator, p, std::move(*source++)); });
+		}
+
+		return *this;
 	}
-	~array() { delete[] m_Data; }
 
 	// Methods
 
 	const size_t size() const { return m_Size; }
+	bool empty() const { return m_Size == 0; }
 
-	T* data() { return m_Data; }
-	const T* data() const { return m_Data; }
+	allocator_type get_allocator() const noexcept { return m_Allocator; }
+
+	T* data() { return aligned(m_Data); }
+	const T* data() const { return aligned(m_Data); }
+
+	// Elements readable past size() thanks to allocator padding, only for padding allocators
+	size_t padded_size() const requires requires { Allocator::padded_size(size_t()); } {
+		return m_Data ? Allocator::padded_size(m_Size) : 0;
+	}
 
 	T& front() { return m_Data[0]; }
 	const T& front() const { return m_Data[0]; }
@@ -79,9 +174,15 @@ public:
 
 	constexpr iterator begin() { return iterator(m_Data); }
 	constexpr iterator end() { return iterator(m_Data + m_Size); }
+	constexpr const_iterator begin() const { return const_iterator(m_Data); }
+	constexpr const_iterator end() const { return const_iterator(m_Data + m_Size); }
+	constexpr const_iterator cbegin() const { return begin(); }
+	constexpr const_iterator cend() const { return end(); }
 
-	constexpr reverse_iterator rbegin() { return reverse_iterator(begin()); }
-	constexpr reverse_iterator rend() { return reverse_iterator(end()); }
+	constexpr reverse_iterator rbegin() { return reverse_iterator(end()); }
+	constexpr reverse_iterator rend() { return reverse_iterator(begin()); }
+	constexpr const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	constexpr const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
 
 	// Operator overloads
 
@@ -92,31 +193,325 @@ public:
 
 private:
 
-	size_t m_Size;
-	T* m_Data;
+	// Local methods
+
+	template<typename P> static P* aligned(P* pointer) {
+		if constexpr (requires { Allocator::alignment; })
+			return std::assume_aligned<Allocator::alignment>(pointer);
+		else return pointer;
+	}
+
+	void allocate(size_t size) {
+		m_Data = size ? traits::allocate(m_Allocator, size) : nullptr;
+		m_Size = size;
+	}
+
+	// Constructs every element with func, rolling back the constructed ones if it throws
+	void construct_with(auto&& func) {
+
+		size_t i = 0;
+
+		try {
+			for (; i < m_Size; i++) func(m_Data + i);
+		} catch (...) {
+			while (i > 0) traits::destroy(m_Allocator, m_Data + --i);
+			traits::deallocate(m_Allocator, m_Data, m_Size);
+			m_Data = nullptr; m_Size = 0;
+			throw;
+		}
+	}
+
+	void copy_from(const array& other) {
+		allocate(other.m_Size);
+		if constexpr (std::is_trivially_copyable_v<T> && skip_construction) {
+			if (m_Size) std::memcpy(m_Data, other.m_Data, m_Size * sizeof(T));
+		} else {
+			auto source = other.m_Data;
+			construct_with([&](T* p) { traits::construct(m_Allocator, p, *source++); });
+		}
+	}
+
+	void reset() noexcept {
+		if (!m_Data) return;
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for (size_t i = 0; i < m_Size; i++) traits::destroy(m_Allocator, m_Data + i);
+		traits::deallocate(m_Allocator, m_Data, m_Size);
+		m_Data = nullptr; m_Size = 0;
+	}
+
+	// Local variables
+
+	[[no_unique_address]] Allocator m_Allocator;
+	size_t m_Size = 0;
+	T* m_Data = nullptr;
 
 };
 
-template<typename T = size_t> class Range {
+namespace ns::pmr {
+	template<typename T = int> using array = ::array<T, std::pmr::polymorphic_allocator<T>>;
+}
+
+template<typename T = float, size_t Alignment = 64> using aligned_array = array<T, ns::aligned_allocator<T, Alignment>>;
+
+// Keeps up to N elements inline and only goes to the allocator for bigger sizes
+
+template<typename T = int, size_t N = 16, typename Allocator = std::allocator<T>> class small_array {
+
+	using traits = std::allocator_traits<Allocator>;
+
+	static constexpr bool skip_construction = std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>;
 
+public:
+
+	using value_type = T;
+	using allocator_type = Allocator;
+	using iterator = ns::iterator<small_array>;
+	using const_iterator = ns::const_iterator<small_array>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	static constexpr size_t inline_capacity = N;
+
+public:
+
+	// Constructors
+
+	small_array(size_t size = 0, const Allocator& allocator = Allocator()) : m_Allocator(allocator) {
+		acquire(size);
+		if constexpr (!skip_construction) construct_with([&](T* p) { traits::construct(m_Allocator, p); });
+	}
+	small_array(size_t size, const T& value, const Allocator& allocator = Allocator()) : m_Allocator(allocator) {
+		acquire(size);
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, value); });
+	}
+	small_array(std::initializer_list<T> list, const Allocator& allocator = Allocator()) : m_Allocator(allocator) {
+		acquire(list.size());
+		auto it = list.begin();
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, *it++); });
+	}
+
+	small_array(const small_array& other) : m_Allocator(traits::select_on_container_copy_construction(other.m_Allocator)) {
+		acquire(other.m_Size);
+		auto source = other.m_Data;
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, *source++); });
+	}
+
+	small_array(small_array&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : m_Allocator(other.m_Allocator) { take(other); }
+
+	~small_array() { reset(); }
+
+	// Assignment
+
+	small_array& operator=(const small_array& other) {
+		if (this == &other) return *this;
+
+		reset();
+		if constexpr (traits::propagate_on_container_copy_assignment::value)
+			m_Allocator = other.m_Allocator;
+
+		acquire(other.m_Size);
+		auto source = other.m_Data;
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, *source++); });
+
+		return *this;
+	}
+
+	small_array& operator=(small_array&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+		if (this != &other) { reset(); take(other); }
+		return *this;
+	}
+
+	// Methods
+
+	const size_t size() const { return m_Size; }
+	bool empty() const { return m_Size == 0; }
+	bool is_inline() const { return m_Size <= N; }
+
+	allocator_type get_allocator() const noexcept { return m_Allocator; }
+
+	T* data() { return m_Data; }
+	const T* data() const { return m_Data; }
+
+	T& front() { return m_Data[0]; }
+	const T& front() const { return m_Data[0]; }
+	T& back() { return m_Data[m_Size - 1]; }
+	const T& back() const { return m_Data[m_Size - 1]; }
+
+	constexpr iterator begin() { return iterator(m_Data); }
+	constexpr iterator end() { return iterator(m_Data + m_Size); }
+	constexpr const_iterator begin() const { return const_iterator(m_Data); }
+	constexpr const_iterator end() const { return const_iterator(m_Data + m_Size); }
+	constexpr const_iterator cbegin() const { return begin(); }
+	constexpr const_iterator cend() const { return end(); }
+
+	constexpr reverse_iterator rbegin() { return reverse_iterator(end()); }
+	constexpr reverse_iterator rend() { return reverse_iterator(begin()); }
+	constexpr const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	constexpr const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	// Operator overloads
+
+	T& operator[](size_t offset) { return m_Data[offset]; }
+	const T& operator[](size_t offset) const { return m_Data[offset]; }
+
+private:
+
+	// Local methods
+
+	T* inline_data() noexcept { return reinterpret_cast<T*>(m_Buffer); }
+
+	void acquire(size_t size) {
+		m_Data = size <= N ? inline_data() : traits::allocate(m_Allocator, size);
+		m_Size = size;
+	}
+
+	void construct_with(auto&& func) {
+
+		size_t i = 0;
+
+		try {
+			for (; i < m_Size; i++) func(m_Data + i);
+		} catch (...) {
+			while (i > 0) traits::destroy(m_Allocator, m_Data + --i);
+			release();
+			throw;
+		}
+	}
+
+	// Heap storage is stolen, inline elements have to be moved one by one.
+	// A propagating allocator comes along either way, before anything is acquired with it
+	void take(small_array& other) {
+
+		if constexpr (traits::propagate_on_container_move_assignment::value) m_Allocator = other.m_Allocator;
+
+		if (!other.is_inline() && (traits::propagate_on_container_move_assignment::value || m_Allocator == other.m_Allocator)) {
+			m_Data = std::exchange(other.m_Data, other.inline_data());
+			m_Size = std::exchange(other.m_Size, 0);
+			return;
+		}
+
+		acquire(other.m_Size);
+		auto source = other.m_Data;
+		construct_with([&](T* p) { traits::construct(m_Allocator, p, std::move(*source++)); });
+		other.reset();
+	}
+
+	void release() noexcept {
+		if (!is_inline()) traits::deallocate(m_Allocator, m_Data, m_Size);
+		m_Data = inline_data(); m_Size = 0;
+	}
+
+	void reset() noexcept {
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for (size_t i = 0; i < m_Size; i++) traits::destroy(m_Allocator, m_Data + i);
+		release();
+	}
+
+	// Local variables
+
+	[[no_unique_address]] Allocator m_Allocator;
+	size_t m_Size = 0;
+	T* m_Data = nullptr;
+	alignas(T) std::byte m_Buffer[N * sizeof(T)];
+
+};
+
+// Integers from start up to stop (exclusive) going by step, a random access
+// view that can be sliced into independent pieces for parallel loops
+
+template<std::integral T = size_t> class Range : public std::ranges::view_interface<Range<T>> {
+
+	using step_type = std::make_signed_t<T>;
+
+public:
+
+	// Holds the index and works the value out on dereference, so moving past the
+	// last element never steps T outside [start, stop) or overflows it
 	struct iterator {
-		iterator(T Data) : m_Data(Data) {}
-		T operator*() const { return m_Data; }
-		iterator& operator++() { m_Data++; return *this; }
-		bool operator==(const iterator& other) const { return m_Data == other.m_Data; }
+
+		using difference_type = std::ptrdiff_t;
+		using value_type = T;
+		using reference = T;
+
+		// Elements are produced by value, which only makes an input iterator to the
+		// classic algorithms, the same as std::views::iota. Ranges see random access
+		using iterator_category = std::input_iterator_tag;
+		using iterator_concept = std::random_access_iterator_tag;
+
+		iterator() = default;
+		constexpr iterator(T Start, step_type Step, difference_type Index) : m_Start(Start), m_Step(Step), m_Index(Index) {}
+
+		// Wraps modulo 2^64 and converts back, exact for every index inside the range
+		constexpr T operator*() const noexcept { return T(size_t(m_Start) + size_t(m_Index) * size_t(m_Step)); }
+		constexpr T operator[](difference_type offset) const noexcept { return *(*this + offset); }
+
+		constexpr iterator& operator++() noexcept { m_Index++; return *this; }
+		constexpr iterator operator++(int) noexcept { auto Tmp = *this; ++*this; return Tmp; }
+		constexpr iterator& operator--() noexcept { m_Index--; return *this; }
+		constexpr iterator operator--(int) noexcept { auto Tmp = *this; --*this; return Tmp; }
+
+		constexpr iterator& operator+=(difference_type offset) noexcept { m_Index += offset; return *this; }
+		constexpr iterator& operator-=(difference_type offset) noexcept { m_Index -= offset; return *this; }
+
+		friend constexpr iterator operator+(iterator It, difference_type offset) noexcept { return It += offset; }
+		friend constexpr iterator operator+(difference_type offset, iterator It) noexcept { return It += offset; }
+		friend constexpr iterator operator-(iterator It, difference_type offset) noexcept { return It -= offset; }
+
+		friend constexpr difference_type operator-(iterator lhs, iterator rhs) noexcept { return lhs.m_Index - rhs.m_Index; }
+
+		friend constexpr bool operator==(iterator lhs, iterator rhs) noexcept { return lhs.m_Index == rhs.m_Index; }
+		friend constexpr auto operator<=>(iterator lhs, iterator rhs) noexcept { return lhs.m_Index <=> rhs.m_Index; }
+
 	private:
-		T m_Data;
+		T m_Start = 0;
+		step_type m_Step = 1;
+		difference_type m_Index = 0;
 	};
 
-public:
+	// Constructors
+
+	Range() = default;
+	constexpr Range(T max) : Range(0, max) {}
+	constexpr Range(T start, T stop, step_type step = 1) : m_Data(start), m_Step(step) {
+		// Distances are taken as size_t, stop - start itself can overflow T
+		if (step > 0 && stop > start) m_Size = steps(size_t(stop) - size_t(start), size_t(step));
+		else if (step < 0 && start > stop) m_Size = steps(size_t(start) - size_t(stop), size_t(0) - size_t(step));
+	}
 
-	Range(T max) : m_Max(max) {}
+	// Methods
+
+	constexpr iterator begin() const noexcept { return iterator(m_Data, m_Step, 0); }
+	constexpr iterator end() const noexcept { return iterator(m_Data, m_Step, std::ptrdiff_t(m_Size)); }
 
-	iterator begin() { return iterator(m_Data); }
-	iterator end() { return iterator(m_Data + m_Max); }
+	constexpr size_t size() const noexcept { return m_Size; }
+	constexpr step_type step() const noexcept { return m_Step; }
+
+	// Elements [first, last) of this range as a range of their own
+	constexpr Range slice(size_t first, size_t last) const noexcept {
+		last = std::min(last, m_Size); first = std::min(first, last);
+		Range result = *this;
+		if (first < m_Size) result.m_Data = begin()[std::ptrdiff_t(first)];
+		result.m_Size = last - first;
+		return result;
+	}
+
+	// Cuts the range into count nearly equal consecutive pieces
+	std::vector<Range> split(size_t count) const {
+		auto pieces = std::vector<Range>();
+		count = std::max<size_t>(1, std::min(count, m_Size));
+		for (size_t i = 0; i < count; i++)
+			pieces.push_back(slice(m_Size * i / count, m_Size * (i + 1) / count));
+		return pieces;
+	}
 
 private:
 
+	// Steps of step needed to cover distance, rounded up without overflowing
+	static constexpr size_t steps(size_t distance, size_t step) noexcept { return distance / step + (distance % step != 0); }
+
 	T m_Data = 0;
-	T m_Max;
-};
\ No newline at end of file
+	step_type m_Step = 1;
+	size_t m_Size = 0;
+};
+
+template<std::integral T> inline constexpr bool std::ranges::enable_borrowed_range<Range<T>> = true;
@@ -0,0 +1,187 @@
+#include "Factor.hpp"
+#include "Primes.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace RozeFoundUtils::primes {
+
+    namespace {
+
+        // Primes below this are stripped by trial division before rho runs
+        constexpr uint64_t trial_bound = 1024;
+
+        uint64_t pollard_brent(uint64_t n) {
+
+            montgomery space(n);
+
+            for (uint64_t c = 1; ; c++) {
+
+                const uint64_t step = space.to(c);
+                auto f = [&](uint64_t x) { return space.add(space.mul(x, x), step); };
+
+                uint64_t y = space.to(2), x = y, saved = y, product = space.to(1), divisor = 1;
+
+                // Gcds are taken over batches of differences to amortise their cost
+                constexpr uint64_t batch = 128;
+
+                for (uint64_t length = 1; divisor == 1; length *= 2) {
+
+                    x = y;
+                    for (uint64_t i = 0; i < length; i++) y = f(y);
+
+                    for (uint64_t done = 0; done < length && divisor == 1; done += batch) {
+
+                        saved = y;
+                        for (uint64_t i = 0; i < std::min(batch, length - done); i++) {
+                            y = f(y);
+                            product = space.mul(product, x > y ? x - y : y - x);
+                        }
+
+                        divisor = std::gcd(space.from(product), n);
+                    }
+                }
+
+                // The batch overshot, walk it again one step at a time
+                if (divisor == n) {
+                    do {
+                        saved = f(saved);
+                        divisor = std::gcd(x > saved ? x - saved : saved - x, n);
+                    } while (divisor == 1);
+                }
+
+                if (divisor != n) return divisor;
+            }
+        }
+
+        void factorize_into(uint64_t n, std::vector<uint64_t>& factors) {
+
+            if (n == 1) return;
+
+            if (is_prime_u64(n)) {
+                factors.push_back(n);
+                return;
+            }
+
+            uint64_t divisor = pollard_brent(n);
+            factorize_into(divisor, factors);
+            factorize_into(n / divisor, factors);
+        }
+    }
+
+    bool is_prime_u64(uint64_t n) {
+
+        if (n < table_bound) return is_prime(n);
+
+        for (uint64_t p : table<table_bound>) {
+            if (p >= 64) break;
+            if (n % p == 0) return false;
+        }
+
+        return miller_rabin(n);
+
+    }
+
+    bool miller_rabin(uint64_t n) {
+
+        montgomery space(n);
+
+        uint64_t d = n - 1;
+        int shift = std::countr_zero(d);
+        d >>= shift;
+
+        const uint64_t one = space.to(1), minus_one = space.to(n - 1);
+
+        // Three bases are enough below 4759123141, seven cover every 64-bit number
+        constexpr uint64_t small_bases[] = { 2, 7, 61 };
+        constexpr uint64_t bases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+        for (uint64_t base : n < 4759123141 ? std::span<const uint64_t>(small_bases) : std::span<const uint64_t>(bases)) {
+
+            if (base % n == 0) continue;
+
+            uint64_t x = space.pow(space.to(base), d);
+            if (x == one || x == minus_one) continue;
+
+            bool composite = true;
+            for (int i = 1; i < shift && composite; i++) {
+                x = space.mul(x, x);
+                composite = x != minus_one;
+            }
+
+            if (composite) return false;
+        }
+
+        return true;
+
+    }
+
+    std::vector<uint64_t> factorize(uint64_t n) {
+
+        auto factors = std::vector<uint64_t>();
+        if (n < 2) return factors;
+
+        for (uint64_t p : table<table_bound>) {
+            if (p >= trial_bound || p * p > n) break;
+            while (n % p == 0) { factors.push_back(p); n /= p; }
+        }
+
+        if (n < trial_bound * trial_bound) {
+            if (n > 1) factors.push_back(n);
+            return factors;
+        }
+
+        factorize_into(n, factors);
+        std::sort(factors.begin(), factors.end());
+
+        return factors;
+
+    }
+
+    std::vector<std::vector<uint64_t>> factorize(std::span<const uint64_t> values) {
+
+        auto result = std::vector<std::vector<uint64_t>>(values.size());
+
+        parallel_chunks(0, values.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++)
+                result[i] = factorize(values[i]);
+        });
+
+        return result;
+
+    }
+
+    spf_sieve::spf_sieve(uint32_t limit) : m_Factors(limit) {
+
+        for (uint32_t i = 2; i < limit; i++) {
+
+            if (m_Factors[i] == 0) {
+                m_Factors[i] = i;
+                m_Primes.push_back(i);
+            }
+
+            // Every composite is crossed off exactly once, by its smallest prime factor
+            for (uint32_t p : m_Primes) {
+                if (p > m_Factors[i] || uint64_t(i) * p >= limit) break;
+                m_Factors[i * p] = p;
+            }
+        }
+
+    }
+
+    std::vector<uint32_t> spf_sieve::factorize(uint32_t n) const {
+
+        auto factors = std::vector<uint32_t>();
+
+        while (n > 1) {
+            uint32_t p = smallest_factor(n);
+            factors.push_back(p);
+            n /= p;
+        }
+
+        return factors;
+
+    }
+}
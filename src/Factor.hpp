@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RozeFoundUtils {
+
+	namespace primes {
+
+		// Arithmetic modulo an odd 64-bit n in Montgomery form, values stay below n
+
+		class montgomery {
+
+		public:
+
+			explicit montgomery(uint64_t n) noexcept : m_N(n), m_Inverse(n) {
+
+				// Newton iteration, every step doubles the number of correct low bits
+				for (int i = 0; i < 5; i++) m_Inverse *= 2 - n * m_Inverse;
+
+				auto r = uint64_t(((unsigned __int128)(1) << 64) % n);
+				m_R2 = uint64_t((unsigned __int128)(r) * r % n);
+			}
+
+			uint64_t modulus() const noexcept { return m_N; }
+
+			uint64_t reduce(unsigned __int128 t) const noexcept {
+				uint64_t m = uint64_t(t) * m_Inverse;
+				uint64_t high = uint64_t(t >> 64), correction = uint64_t(((unsigned __int128)(m) * m_N) >> 64);
+				return high < correction ? high - correction + m_N : high - correction;
+			}
+
+			uint64_t to(uint64_t x) const noexcept { return reduce((unsigned __int128)(x % m_N) * m_R2); }
+			uint64_t from(uint64_t x) const noexcept { return reduce(x); }
+
+			uint64_t mul(uint64_t a, uint64_t b) const noexcept { return reduce((unsigned __int128)(a) * b); }
+
+			uint64_t add(uint64_t a, uint64_t b) const noexcept {
+				uint64_t sum = a + b;
+				return (sum < a || sum >= m_N) ? sum - m_N : sum;
+			}
+
+			uint64_t pow(uint64_t base, uint64_t exponent) const noexcept {
+				uint64_t result = to(1);
+				for (; exponent; exponent >>= 1, base = mul(base, base))
+					if (exponent & 1) result = mul(result, base);
+				return result;
+			}
+
+		private:
+
+			uint64_t m_N, m_Inverse, m_R2;
+		};
+
+		// Deterministic Miller-Rabin for the whole 64-bit range
+		bool is_prime_u64(uint64_t n);
+
+		// The Miller-Rabin rounds alone for odd n > 64, when small factors were already ruled out
+		bool miller_rabin(uint64_t n);
+
+		// Prime factors of n in ascending order, repeated by multiplicity.
+		// Small factors go by trial division, the rest by Pollard-Brent rho
+		std::vector<uint64_t> factorize(uint64_t n);
+
+		// Factorises every value, spread over all hardware threads
+		std::vector<std::vector<uint64_t>> factorize(std::span<const uint64_t> values);
+
+		// Smallest prime factor of every number below the limit via a linear sieve,
+		// for factorising whole ranges by repeated lookup
+
+		class spf_sieve {
+
+		public:
+
+			explicit spf_sieve(uint32_t limit);
+
+			uint32_t limit() const noexcept { return uint32_t(m_Factors.size()); }
+			const std::vector<uint32_t>& primes() const noexcept { return m_Primes; }
+
+			uint32_t smallest_factor(uint32_t n) const { return m_Factors.at(n); }
+
+			std::vector<uint32_t> factorize(uint32_t n) const;
+
+		private:
+
+			std::vector<uint32_t> m_Factors;
+			std::vector<uint32_t> m_Primes;
+		};
+	}
+}
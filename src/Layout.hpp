@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "Utils.hpp"
+
+namespace RozeFoundUtils {
+
+	// Declarative description of a foreign struct: fields are described once,
+	// the whole struct is copied in one go and fields are read from the copy.
+
+	template<std::size_t N> struct fixed_string {
+
+		constexpr fixed_string(const char (&string)[N]) { std::copy_n(string, N, data); }
+
+		constexpr operator std::string_view() const { return { data, N - 1 }; }
+		constexpr bool operator==(const fixed_string&) const = default;
+
+		char data[N] = {};
+	};
+
+	template<fixed_string Name, typename T, std::ptrdiff_t Offset> struct field {
+
+		static_assert(std::is_trivially_copyable_v<T>, "field type must be trivially copyable");
+		static_assert(Offset >= 0, "field offset must be non-negative");
+
+		using type = T;
+		static constexpr auto name = Name;
+		static constexpr std::ptrdiff_t offset = Offset;
+		static constexpr std::size_t end = Offset + sizeof(T);
+	};
+
+	namespace detail {
+
+		template<fixed_string Name, typename Field, typename ... Fields> consteval auto find_field() {
+			if constexpr (std::string_view(Field::name) == std::string_view(Name)) return Field();
+			else {
+				static_assert(sizeof...(Fields) > 0, "no field with such name in layout");
+				return find_field<Name, Fields...>();
+			}
+		}
+
+	}
+
+	template<typename ... Fields> struct layout {
+
+		static_assert(sizeof...(Fields) > 0, "layout must describe at least one field");
+
+		static constexpr std::size_t size = std::max({ Fields::end ... });
+
+		template<fixed_string Name> using field_t = decltype(detail::find_field<Name, Fields...>());
+
+		class snapshot {
+
+		public:
+
+			template<fixed_string Name> auto get() const noexcept {
+				using F = field_t<Name>;
+				typename F::type value;
+				std::memcpy(&value, m_Bytes.data() + F::offset, sizeof(value));
+				return value;
+			}
+
+			std::byte* data() noexcept { return m_Bytes.data(); }
+			const std::byte* data() const noexcept { return m_Bytes.data(); }
+
+		private:
+
+			alignas(std::max_align_t) std::array<std::byte, size> m_Bytes = {};
+		};
+
+		// Local memory
+
+		static snapshot read(const void* address) noexcept {
+			snapshot result;
+			std::memcpy(result.data(), address, size);
+			return result;
+		}
+
+		static snapshot read(const auto& object) noexcept requires (!std::is_pointer_v<std::remove_cvref_t<decltype(object)>>) {
+			return read(static_cast<const void*>(std::addressof(object)));
+		}
+
+		// Remote memory, every snapshot is fetched with a single batched read
+
+		static std::optional<snapshot> read(uint32_t process_id, std::ptrdiff_t address) {
+			snapshot result;
+			if (!read_process_memory(process_id, address, result.data(), size)) return std::nullopt;
+			return result;
+		}
+
+		static std::vector<snapshot> read(uint32_t process_id, std::span<const std::ptrdiff_t> addresses) {
+
+			auto result = std::vector<snapshot>(addresses.size());
+			auto buffers = std::vector<std::byte*>(addresses.size());
+
+			for (std::size_t i = 0; i < addresses.size(); i++)
+				buffers[i] = result[i].data();
+
+			if (!read_process_memory(process_id, addresses, buffers, size)) result.clear();
+			return result;
+		}
+	};
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+namespace ns {
+
+	// Bump allocator over growing blocks, deallocate is a no-op and everything
+	// is handed back to upstream at once by release() or destruction.
+	// Not thread-safe, meant to be owned by a single batch or thread.
+
+	class monotonic_arena : public std::pmr::memory_resource {
+
+		struct block {
+			block* previous;
+			std::size_t size;
+		};
+
+	public:
+
+		// Constructors
+
+		explicit monotonic_arena(std::size_t initial_size = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: m_NextSize(std::max<std::size_t>(initial_size, 256)), m_Upstream(upstream) {}
+
+		monotonic_arena(const monotonic_arena&) = delete;
+		monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+		~monotonic_arena() override { release(); }
+
+		// Methods
+
+		void release() noexcept {
+
+			while (m_Blocks) {
+				auto previous = m_Blocks->previous;
+				m_Upstream->deallocate(m_Blocks, m_Blocks->size, alignof(std::max_align_t));
+				m_Blocks = previous;
+			}
+
+			m_Current = m_End = nullptr;
+		}
+
+		std::pmr::memory_resource* upstream_resource() const noexcept { return m_Upstream; }
+
+	private:
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+
+			auto current = reinterpret_cast<std::uintptr_t>(m_Current);
+			auto aligned = (current + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+
+			if (!m_Current || aligned + bytes > reinterpret_cast<std::uintptr_t>(m_End)) {
+				grow(bytes + alignment);
+				current = reinterpret_cast<std::uintptr_t>(m_Current);
+				aligned = (current + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+			}
+
+			m_Current = reinterpret_cast<std::byte*>(aligned + bytes);
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		void grow(std::size_t minimum) {
+
+			std::size_t size = std::max(m_NextSize, std::bit_ceil(minimum + sizeof(block)));
+			auto memory = static_cast<block*>(m_Upstream->allocate(size, alignof(std::max_align_t)));
+
+			*memory = { m_Blocks, size };
+			m_Blocks = memory;
+			m_Current = reinterpret_cast<std::byte*>(memory + 1);
+			m_End = reinterpret_cast<std::byte*>(memory) + size;
+			m_NextSize = size * 2;
+		}
+
+		block* m_Blocks = nullptr;
+		std::byte* m_Current = nullptr;
+		std::byte* m_End = nullptr;
+
+		std::size_t m_NextSize;
+		std::pmr::memory_resource* m_Upstream;
+	};
+
+	// Segregated free lists for power of two size classes from 16 bytes up to
+	// max_pooled, bigger requests go straight to upstream. Memory returned to
+	// a pool is reused by the next allocation of the same class.
+	// Not thread-safe, use one per thread to keep allocation free of contention.
+
+	class pool_resource : public std::pmr::memory_resource {
+
+		static constexpr std::size_t min_class = 16;
+		static constexpr std::size_t max_pooled = 4096;
+		static constexpr std::size_t class_count = std::countr_zero(max_pooled) - std::countr_zero(min_class) + 1;
+
+		struct node { node* next; };
+
+	public:
+
+		// Constructors
+
+		explicit pool_resource(std::size_t chunk_size = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: m_Arena(chunk_size, upstream) {}
+
+		pool_resource(const pool_resource&) = delete;
+		pool_resource& operator=(const pool_resource&) = delete;
+
+		// Methods
+
+		void release() noexcept { m_Arena.release(); m_FreeLists = {}; }
+
+		std::pmr::memory_resource* upstream_resource() const noexcept { return m_Arena.upstream_resource(); }
+
+	private:
+
+		static std::size_t size_class(std::size_t bytes, std::size_t alignment) noexcept {
+			auto size = std::bit_ceil(std::max({ bytes, alignment, min_class }));
+			return std::countr_zero(size) - std::countr_zero(min_class);
+		}
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+
+			if (std::max(bytes, alignment) > max_pooled)
+				return upstream_resource()->allocate(bytes, alignment);
+
+			auto index = size_class(bytes, alignment);
+
+			if (auto head = m_FreeLists[index]) {
+				m_FreeLists[index] = head->next;
+				return head;
+			}
+
+			// Blocks are aligned to their own size, so any alignment up to the class size holds
+			auto size = min_class << index;
+			return m_Arena.allocate(size, size);
+		}
+
+		void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+
+			if (std::max(bytes, alignment) > max_pooled)
+				return upstream_resource()->deallocate(pointer, bytes, alignment);
+
+			auto index = size_class(bytes, alignment);
+			m_FreeLists[index] = new (pointer) node { m_FreeLists[index] };
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		monotonic_arena m_Arena;
+		std::array<node*, class_count> m_FreeLists = {};
+	};
+
+	// Allocator handing out storage aligned to Alignment and padded up to a
+	// whole number of Alignment-sized blocks, the padding is zeroed so vector
+	// kernels can run over the tail without a scalar remainder loop.
+
+	template<typename T, std::size_t Alignment = 64> struct aligned_allocator {
+
+		static_assert(std::has_single_bit(Alignment) && Alignment >= alignof(T), "alignment must be a power of two not below alignof(T)");
+
+		using value_type = T;
+		using is_always_equal = std::true_type;
+
+		static constexpr std::size_t alignment = Alignment;
+
+		template<typename U> struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+		aligned_allocator() noexcept = default;
+		template<typename U> aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+		// Number of elements actually backed by an allocation of count elements
+		static constexpr std::size_t padded_size(std::size_t count) noexcept {
+			return ((count * sizeof(T) + Alignment - 1) / Alignment * Alignment) / sizeof(T);
+		}
+
+		[[nodiscard]] T* allocate(std::size_t count) {
+
+			std::size_t bytes = (count * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+			auto memory = static_cast<std::byte*>(::operator new(bytes, std::align_val_t(Alignment)));
+
+			std::memset(memory + count * sizeof(T), 0, bytes - count * sizeof(T));
+
+			return reinterpret_cast<T*>(memory);
+		}
+
+		void deallocate(T* pointer, std::size_t) noexcept {
+			::operator delete(pointer, std::align_val_t(Alignment));
+		}
+
+		template<typename U> bool operator==(const aligned_allocator<U, Alignment>&) const noexcept { return true; }
+	};
+}
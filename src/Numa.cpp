@@ -0,0 +1,153 @@
+#include "Numa.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace RozeFoundUtils::numa {
+
+    namespace {
+
+        std::vector<int> allowed_cpus() {
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+
+            std::vector<int> cpus;
+
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                    if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+
+            if (cpus.empty())
+                for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++)
+                    cpus.push_back(int(cpu));
+
+            return cpus;
+        }
+    }
+
+    std::vector<int> parse_cpulist(std::string_view list) {
+
+        std::vector<int> cpus;
+
+        for (auto range : list | ext::split_by(',')) {
+
+            while (!range.empty() && std::isspace((unsigned char)range.back())) range.remove_suffix(1);
+            if (range.empty()) continue;
+
+            int first = 0, last = 0;
+            auto dash = range.find('-');
+
+            std::from_chars(range.data(), range.data() + range.size(), first);
+            last = first;
+            if (dash != std::string_view::npos)
+                std::from_chars(range.data() + dash + 1, range.data() + range.size(), last);
+
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+
+        return cpus;
+
+    }
+
+    const topology& topology::system() {
+
+        static const topology instance = read();
+        return instance;
+
+    }
+
+    topology topology::read(const std::filesystem::path& root) {
+
+        namespace fs = std::filesystem;
+
+        topology result;
+        auto allowed = allowed_cpus();
+
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(root, ec)) {
+
+            auto name = entry.path().filename().string();
+            if (!name.starts_with("node") || name.size() == 4 || !std::isdigit((unsigned char)name[4])) continue;
+
+            std::string list;
+            try { list = read_from_file(entry.path() / "cpulist").value_or(""); }
+            catch (const std::exception&) { continue; }
+
+            node n { std::stoi(name.substr(4)), {} };
+            for (int cpu : parse_cpulist(list))
+                if (std::binary_search(allowed.begin(), allowed.end(), cpu)) n.cpus.push_back(cpu);
+
+            // Memory-only nodes and nodes outside our affinity have nothing to run on
+            if (!n.cpus.empty()) result.m_Nodes.push_back(std::move(n));
+        }
+
+        std::ranges::sort(result.m_Nodes, {}, &node::id);
+
+        if (result.m_Nodes.empty()) result.m_Nodes.push_back({ 0, std::move(allowed) });
+
+        return result;
+
+    }
+
+    std::size_t topology::cpu_count() const noexcept {
+
+        std::size_t count = 0;
+        for (const auto& n : m_Nodes) count += n.cpus.size();
+
+        return count;
+
+    }
+
+    int topology::node_of(int cpu) const noexcept {
+
+        for (const auto& n : m_Nodes)
+            if (std::ranges::find(n.cpus, cpu) != n.cpus.end()) return n.id;
+
+        return -1;
+
+    }
+
+    int topology::cpu_for(std::size_t worker, std::size_t workers) const noexcept {
+
+        std::size_t count = m_Nodes.size();
+        workers = std::max<std::size_t>(workers, 1);
+
+        // Workers [first, next) of the split belong to node index
+        std::size_t index = worker * count / workers;
+        std::size_t first = (index * workers + count - 1) / count;
+
+        const auto& cpus = m_Nodes[index].cpus;
+        return cpus[(worker - first) % cpus.size()];
+
+    }
+
+    bool pin_thread(int cpu) noexcept {
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+
+    }
+
+    scoped_pin::scoped_pin(int cpu) noexcept : m_Previous(sizeof(cpu_set_t)) {
+
+        m_Saved = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), reinterpret_cast<cpu_set_t*>(m_Previous.data())) == 0;
+        if (m_Saved) pin_thread(cpu);
+
+    }
+
+    scoped_pin::~scoped_pin() {
+        if (m_Saved) pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), reinterpret_cast<cpu_set_t*>(m_Previous.data()));
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace RozeFoundUtils {
+
+	namespace numa {
+
+		struct node {
+			int id;
+			std::vector<int> cpus;
+		};
+
+		// NUMA nodes and the CPUs of each this process may run on. Machines or
+		// kernels without /sys/devices/system/node show up as a single node
+
+		class topology {
+
+		public:
+
+			// Read once and cached
+			static const topology& system();
+
+			static topology read(const std::filesystem::path& root = "/sys/devices/system/node");
+
+			const std::vector<node>& nodes() const noexcept { return m_Nodes; }
+			std::size_t cpu_count() const noexcept;
+
+			// Node the CPU belongs to, -1 when it isn't one this process may use
+			int node_of(int cpu) const noexcept;
+
+			// CPU for worker `worker` out of `workers`. Workers are spread over the nodes in
+			// proportion and consecutive workers share a node, so neighbouring chunks stay local
+			int cpu_for(std::size_t worker, std::size_t workers) const noexcept;
+
+		private:
+
+			std::vector<node> m_Nodes;
+		};
+
+		// "0-3,8,10-11" -> 0 1 2 3 8 10 11
+		std::vector<int> parse_cpulist(std::string_view list);
+
+		// Restricts the calling thread to one CPU
+		bool pin_thread(int cpu) noexcept;
+
+		// Pins the calling thread for the scope, the previous affinity comes back afterwards
+
+		class scoped_pin {
+
+		public:
+
+			// Constructors
+
+			explicit scoped_pin(int cpu) noexcept;
+			scoped_pin(const scoped_pin&) = delete;
+			scoped_pin& operator=(const scoped_pin&) = delete;
+			~scoped_pin();
+
+		private:
+
+			// Local variables
+
+			std::vector<unsigned char> m_Previous;
+			bool m_Saved = false;
+		};
+	}
+}
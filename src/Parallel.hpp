@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Utils.hpp"
+#include "Sort.hpp"
+
+namespace RozeFoundUtils {
+
+	namespace parallel {
+
+		namespace detail {
+
+			inline size_t thread_count(size_t size, size_t grain) {
+				size_t threads = std::max(1u, std::thread::hardware_concurrency());
+				return std::clamp<size_t>(size / grain, 1, threads);
+			}
+
+			constexpr size_t grain = 1 << 14;
+		}
+
+		template<std::ranges::random_access_range R, typename T>
+		void fill(R&& range, const T& value) {
+
+			auto first = std::ranges::begin(range);
+			size_t size = std::ranges::size(range);
+
+			parallel_chunks(0, size, [&](size_t begin, size_t end, size_t) {
+				std::fill(first + begin, first + end, value);
+			}, detail::thread_count(size, detail::grain));
+		}
+
+		// Linux places a page on the node of the thread that first writes it. Initialising
+		// with the same split and thread count as the parallel_for that later works on
+		// the range puts every chunk's pages next to the thread that processes them.
+		// Only useful on memory nothing has written yet, see make_first_touch
+
+		template<std::ranges::random_access_range R, typename T>
+		void first_touch(R&& range, const T& value, size_t thread_count = 0) {
+
+			auto first = std::ranges::begin(range);
+
+			parallel_chunks(0, std::ranges::size(range), [&](size_t begin, size_t end, size_t) {
+				std::fill(first + begin, first + end, value);
+			}, thread_count);
+		}
+
+		// Array allocated without touching it and then first touched in parallel,
+		// unlike std::vector which zeroes everything from the calling thread
+
+		template<typename T> std::unique_ptr<T[]> make_first_touch(size_t size, const T& value = T(), size_t thread_count = 0) {
+			auto result = std::make_unique_for_overwrite<T[]>(size);
+			first_touch(std::span(result.get(), size), value, thread_count);
+			return result;
+		}
+
+		template<std::ranges::random_access_range R, std::random_access_iterator Out, typename F>
+		Out transform(R&& range, Out out, F function) {
+
+			auto first = std::ranges::begin(range);
+			size_t size = std::ranges::size(range);
+
+			parallel_chunks(0, size, [&](size_t begin, size_t end, size_t) {
+				std::transform(first + begin, first + end, out + begin, function);
+			}, detail::thread_count(size, detail::grain));
+
+			return out + size;
+		}
+
+		template<std::ranges::random_access_range R, typename Predicate>
+		size_t count_if(R&& range, Predicate predicate) {
+
+			auto first = std::ranges::begin(range);
+			size_t size = std::ranges::size(range);
+
+			std::atomic<size_t> count = 0;
+
+			parallel_chunks(0, size, [&](size_t begin, size_t end, size_t) {
+				count += std::count_if(first + begin, first + end, predicate);
+			}, detail::thread_count(size, detail::grain));
+
+			return count;
+		}
+
+		// Sample sort: splitters picked from a sorted oversample route every element
+		// into one of several buckets per thread, buckets are then sorted independently.
+		// Elements equal to a splitter get a bucket of their own that needs no sorting,
+		// so heavily repeated keys don't pile up in one bucket sorted by one thread
+
+		template<std::ranges::random_access_range R, typename Compare = std::ranges::less>
+			requires std::sortable<std::ranges::iterator_t<R>, Compare> && std::default_initializable<std::ranges::range_value_t<R>>
+		void sort(R&& range, Compare compare = {}) {
+
+			using T = std::ranges::range_value_t<R>;
+
+			auto first = std::ranges::begin(range);
+			size_t size = std::ranges::size(range);
+
+			// Plain ascending sort of numbers goes to the radix sort instead
+			if constexpr (std::same_as<Compare, std::ranges::less> && std::ranges::contiguous_range<R>
+				&& RozeFoundUtils::detail::radix::key<T>)
+				return radix_sort(range, std::identity(), true);
+
+			size_t threads = detail::thread_count(size, detail::grain * 4);
+			if (threads == 1) return std::sort(first, first + size, compare);
+
+			constexpr size_t oversample = 32;
+			size_t bucket_count = threads * 4;
+
+			auto samples = std::vector<T>();
+			samples.reserve(bucket_count * oversample);
+			for (size_t i = 0; i < bucket_count * oversample; i++)
+				samples.push_back(first[size * i / (bucket_count * oversample)]);
+			std::sort(samples.begin(), samples.end(), compare);
+
+			// Repeats among the splitters are dropped, each one left gets an equality bucket
+			auto splitters = std::vector<T>();
+			for (size_t i = 1; i < bucket_count; i++)
+				if (splitters.empty() || compare(splitters.back(), samples[i * oversample]))
+					splitters.push_back(samples[i * oversample]);
+
+			// Bucket 2j holds what lies between splitters j - 1 and j, bucket 2j - 1 what equals splitter j - 1
+			bucket_count = splitters.size() * 2 + 1;
+
+			auto buckets = std::vector<uint32_t>(size);
+			auto counts = std::vector<size_t>(threads * bucket_count);
+
+			parallel_chunks(0, size, [&](size_t begin, size_t end, size_t thread) {
+				auto count = counts.data() + thread * bucket_count;
+				for (size_t i = begin; i < end; i++) {
+					size_t above = std::upper_bound(splitters.begin(), splitters.end(), first[i], compare) - splitters.begin();
+					size_t bucket = above > 0 && !compare(splitters[above - 1], first[i]) ? above * 2 - 1 : above * 2;
+					buckets[i] = uint32_t(bucket);
+					count[bucket]++;
+				}
+			}, threads);
+
+			// Exclusive prefix sum in bucket-major order so every thread gets its own slice of every bucket
+			auto bucket_begin = std::vector<size_t>(bucket_count + 1);
+			for (size_t bucket = 0, offset = 0; bucket < bucket_count; bucket++) {
+				bucket_begin[bucket] = offset;
+				for (size_t thread = 0; thread < threads; thread++)
+					offset += std::exchange(counts[thread * bucket_count + bucket], offset);
+			}
+			bucket_begin[bucket_count] = size;
+
+			// Every slot is moved into before it is read
+			auto scratch = std::make_unique_for_overwrite<T[]>(size);
+
+			parallel_chunks(0, size, [&](size_t begin, size_t end, size_t thread) {
+				auto offset = counts.data() + thread * bucket_count;
+				for (size_t i = begin; i < end; i++)
+					scratch[offset[buckets[i]]++] = std::move(first[i]);
+			}, threads);
+
+			std::atomic<size_t> next_bucket = 0;
+
+			parallel_chunks(0, threads, [&](size_t, size_t, size_t) {
+				for (size_t bucket; (bucket = next_bucket++) < bucket_count; ) {
+					auto begin = bucket_begin[bucket], end = bucket_begin[bucket + 1];
+					if (bucket % 2 == 0) std::sort(scratch.get() + begin, scratch.get() + end, compare);
+					std::move(scratch.get() + begin, scratch.get() + end, first + begin);
+				}
+			}, threads);
+		}
+	}
+}
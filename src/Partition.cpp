@@ -0,0 +1,163 @@
+#include "Partition.hpp"
+
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/core.h>
+
+namespace RozeFoundUtils {
+
+    namespace detail {
+
+        std::vector<chunk> split_even(std::size_t begin, std::size_t end, std::size_t parts) {
+
+            std::size_t size = end - begin;
+            auto bound = [&](std::size_t i) { return begin + std::size_t((unsigned __int128)(size) * i / parts); };
+
+            std::vector<chunk> chunks;
+            chunks.reserve(parts);
+
+            for (std::size_t i = 0; i < parts; i++)
+                chunks.push_back({ bound(i), bound(i + 1) });
+
+            return chunks;
+
+        }
+
+        std::vector<chunk> split_weighted(std::size_t parts, const std::vector<std::size_t>& edges, const std::vector<double>& prefix) {
+
+            std::size_t begin = edges.front(), end = edges.back();
+            double total = prefix.back();
+
+            // Nothing costs anything, so there is nothing to balance
+            if (!(total > 0)) return split_even(begin, end, parts);
+
+            std::vector<chunk> chunks;
+            chunks.reserve(parts);
+
+            std::size_t first = begin;
+
+            for (std::size_t k = 1; k <= parts; k++) {
+
+                std::size_t last = end;
+
+                if (k < parts) {
+                    // Bucket the k-th share ends in, then in proportion inside it
+                    auto target = total * double(k) / double(parts);
+                    auto b = std::size_t(std::lower_bound(prefix.begin() + 1, prefix.end(), target) - prefix.begin());
+                    b = std::min(b, prefix.size() - 1);
+
+                    double inside = prefix[b] - prefix[b - 1];
+                    double share = inside > 0 ? (target - prefix[b - 1]) / inside : 1;
+                    last = edges[b - 1] + std::size_t(share * double(edges[b] - edges[b - 1]));
+                    last = std::clamp(last, first, end);
+                }
+
+                chunks.push_back({ first, last });
+                first = last;
+            }
+
+            return chunks;
+
+        }
+    }
+
+    partitioner::partitioner(std::size_t begin, std::size_t end, std::size_t workers, schedule kind, std::size_t grain, bool descending)
+        : m_Begin(begin), m_End(std::max(begin, end)), m_Grain(std::max<std::size_t>(grain, 1)), m_Kind(kind), m_Descending(descending), m_Cursor(begin) {
+
+        // More workers than indices would only produce empty chunks
+        m_Workers = std::clamp<std::size_t>(workers, 1, std::max<std::size_t>(size(), 1));
+
+        if (m_Kind == schedule::weighted) throw std::invalid_argument("weighted schedule needs a cost per index");
+
+        m_Chunks = detail::split_even(m_Begin, m_End, m_Workers);
+        m_Taken = std::make_unique<std::atomic<bool>[]>(m_Workers);
+
+    }
+
+    std::optional<chunk> partitioner::next(std::size_t worker) noexcept {
+
+        if (m_Kind == schedule::even || m_Kind == schedule::weighted) {
+
+            if (worker >= m_Workers || m_Taken[worker].exchange(true, std::memory_order_relaxed)) return std::nullopt;
+
+            auto part = m_Chunks[worker];
+            if (part.empty()) return std::nullopt;
+            return part;
+        }
+
+        auto position = m_Cursor.load(std::memory_order_relaxed);
+
+        while (position < m_End) {
+
+            std::size_t remaining = m_End - position;
+            std::size_t size = m_Grain;
+
+            // Half of an even share of what is left keeps the last chunks small enough to balance
+            if (m_Kind == schedule::guided) size = std::max(m_Grain, remaining / (2 * m_Workers));
+
+            std::size_t last = position + std::min(size, remaining);
+
+            if (m_Cursor.compare_exchange_weak(position, last, std::memory_order_relaxed)) {
+                // The cursor counts claimed indices, descending mirrors them onto the range
+                if (m_Descending) return chunk { m_Begin + (m_End - last), m_Begin + (m_End - position) };
+                return chunk { position, last };
+            }
+        }
+
+        return std::nullopt;
+
+    }
+
+    double run_stats::idle() const noexcept {
+
+        if (busy.empty() || wall.count() <= 0) return 0;
+
+        auto total = std::accumulate(busy.begin(), busy.end(), std::chrono::nanoseconds(0));
+        return std::max(0.0, 1 - double(total.count()) / (double(wall.count()) * double(busy.size())));
+
+    }
+
+    double run_stats::imbalance() const noexcept {
+
+        if (busy.empty()) return 1;
+
+        auto total = std::accumulate(busy.begin(), busy.end(), std::chrono::nanoseconds(0));
+        if (total.count() <= 0) return 1;
+
+        return double(std::ranges::max(busy).count()) * double(busy.size()) / double(total.count());
+
+    }
+
+    std::string run_stats::summary() const {
+
+        std::string result = fmt::format("{} workers, wall {:.3f}ms, idle {:.1f}%, imbalance {:.2f}",
+            busy.size(), double(wall.count()) * 1e-6, idle() * 100, imbalance());
+
+        for (std::size_t i = 0; i < busy.size(); i++)
+            fmt::format_to(std::back_inserter(result), "\n  worker {}: busy {:.3f}ms, {} chunks, {} indices",
+                i, double(busy[i].count()) * 1e-6, chunks[i], indices[i]);
+
+        return result;
+
+    }
+
+    void run_stats::print(std::string_view name) const {
+        std::cout << name << ": " << summary() << std::endl;
+    }
+
+    partitioner make_partitioner(std::size_t begin, std::size_t end, const parallel_options& options) {
+
+        std::size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        std::size_t size = end > begin ? end - begin : 0;
+        std::size_t grain = options.grain ? options.grain : std::max<std::size_t>(1, size / (threads * 32));
+
+        if (options.cost) return partitioner(begin, end, threads, options.cost);
+        if (options.growing) return partitioner(begin, end, threads, schedule::dynamic, grain, true);
+
+        return partitioner(begin, end, threads, options.kind, grain);
+
+    }
+}
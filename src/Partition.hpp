@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RozeFoundUtils {
+
+	// Half open [begin, end)
+	struct chunk {
+
+		std::size_t begin;
+		std::size_t end;
+
+		std::size_t size() const noexcept { return end - begin; }
+		bool empty() const noexcept { return begin == end; }
+	};
+
+	enum class schedule {
+		even,     // one equal chunk per worker, worker i always gets the i-th slice
+		dynamic,  // workers claim chunks of `grain` indices until the range runs out
+		guided,   // like dynamic but chunks shrink with the remaining work, never below `grain`
+		weighted  // one chunk per worker holding an equal share of a per-index cost, needs the cost
+	};
+
+	namespace detail {
+
+		std::vector<chunk> split_even(std::size_t begin, std::size_t end, std::size_t parts);
+
+		// Boundaries where the running cost crosses every k / parts of the total. Cost is known
+		// per bucket [edges[b], edges[b + 1]) as prefix[b + 1] - prefix[b] and taken as even inside it
+		std::vector<chunk> split_weighted(std::size_t parts, const std::vector<std::size_t>& edges, const std::vector<double>& prefix);
+	}
+
+	// Splits [begin, end) between a number of workers, every index goes to exactly one
+	// chunk. The fixed schedules are decided up front, the others are handed out from
+	// a shared cursor, so a partitioner is used by one parallel run and then thrown away
+
+	class partitioner {
+
+	public:
+
+		// Constructors
+
+		// Descending hands out claimed chunks from the end first, for work that gets more
+		// expensive with the index: the big pieces go early and the cheap ones fill the gaps.
+		// schedule::weighted needs a cost and throws std::invalid_argument here
+		partitioner(std::size_t begin, std::size_t end, std::size_t workers, schedule kind = schedule::even, std::size_t grain = 1, bool descending = false);
+
+		// Weighted by cost(i), e.g. the expected work of index i. Cost is sampled once per
+		// bucket, 64 buckets per worker, so building the split stays cheap on huge ranges
+		template<typename Cost> requires std::invocable<Cost&, std::size_t>
+		partitioner(std::size_t begin, std::size_t end, std::size_t workers, Cost&& cost)
+			: partitioner(begin, end, workers, schedule::even) {
+
+			std::size_t buckets = std::min(size(), m_Workers * 64);
+
+			auto edges = std::vector<std::size_t>();
+			auto prefix = std::vector<double>();
+			edges.reserve(buckets + 1);
+			prefix.reserve(buckets + 1);
+
+			edges.push_back(m_Begin);
+			prefix.push_back(0);
+
+			for (std::size_t b = 1; b <= buckets; b++) {
+				std::size_t first = edges.back(), last = m_Begin + size() * b / buckets;
+				double sample = std::max(0.0, double(std::invoke(cost, first + (last - first) / 2)));
+				edges.push_back(last);
+				prefix.push_back(prefix.back() + sample * double(last - first));
+			}
+
+			m_Kind = schedule::weighted;
+			if (buckets > 0) m_Chunks = detail::split_weighted(m_Workers, edges, prefix);
+		}
+
+		partitioner(const partitioner&) = delete;
+		partitioner& operator=(const partitioner&) = delete;
+
+		// Methods
+
+		schedule kind() const noexcept { return m_Kind; }
+		std::size_t workers() const noexcept { return m_Workers; }
+		std::size_t size() const noexcept { return m_End - m_Begin; }
+
+		// Next chunk for worker, empty once it has nothing left to do. Safe to call
+		// from all workers at once, as long as each passes its own index
+		std::optional<chunk> next(std::size_t worker) noexcept;
+
+		// Calls function(begin, end) for every chunk worker gets
+		template<typename F> void run(std::size_t worker, F&& function) {
+			while (auto part = next(worker))
+				std::invoke(function, part->begin, part->end);
+		}
+
+	private:
+
+		// Local variables
+
+		std::size_t m_Begin;
+		std::size_t m_End;
+		std::size_t m_Workers;
+		std::size_t m_Grain;
+		schedule m_Kind;
+		bool m_Descending = false;
+
+		// Fixed schedules, one chunk per worker and whether it was handed out
+		std::vector<chunk> m_Chunks;
+		std::unique_ptr<std::atomic<bool>[]> m_Taken;
+
+		alignas(64) std::atomic<std::size_t> m_Cursor;
+	};
+
+	// Where the time of a parallel run went, per worker
+
+	struct run_stats {
+
+		std::chrono::nanoseconds wall {};
+		std::vector<std::chrono::nanoseconds> busy;
+		std::vector<std::size_t> chunks;
+		std::vector<std::size_t> indices;
+
+		// Share of workers * wall nobody spent inside a chunk
+		double idle() const noexcept;
+
+		// Busiest worker over the average one, 1 is perfectly balanced
+		double imbalance() const noexcept;
+
+		std::string summary() const;
+		void print(std::string_view name) const;
+	};
+
+	struct parallel_options {
+
+		schedule kind = schedule::even;
+
+		// Expected work of index i, gives a weighted split and overrides kind.
+		// kind = schedule::weighted without it throws std::invalid_argument
+		std::function<double(std::size_t)> cost = {};
+
+		// Work grows with the index but its shape isn't known: small chunks are
+		// claimed from the expensive end first. Ignored when there is a cost
+		bool growing = false;
+
+		// Claimed chunk size, 0 picks one that gives every worker a few dozen chunks
+		std::size_t grain = 0;
+
+		// 0 is one per hardware thread
+		std::size_t threads = 0;
+
+		// Filled in after the run when set
+		run_stats* stats = nullptr;
+	};
+
+	// The partitioner the options describe for [begin, end)
+	partitioner make_partitioner(std::size_t begin, std::size_t end, const parallel_options& options);
+}
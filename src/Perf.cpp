@@ -0,0 +1,162 @@
+#include "Perf.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fmt/format.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RozeFoundUtils::perf {
+
+    namespace {
+
+        struct config {
+            uint32_t type;
+            uint64_t config;
+            const char* name;
+        };
+
+        constexpr config configs[event_count] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles" },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions" },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache misses" },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch misses" },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16), "LLC loads" },
+        };
+
+        int open_event(const config& event, int group) {
+
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = event.type;
+            attr.config = event.config;
+            attr.disabled = group < 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            return int(syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+        }
+
+        // 1234567 -> "1.23M"
+        std::string si(double value) {
+            constexpr const char* suffixes[] = { "", "k", "M", "G", "T" };
+            std::size_t i = 0;
+            for (; value >= 1000 && i < 4; i++) value /= 1000;
+            return i ? fmt::format("{:.3g}{}", value, suffixes[i]) : fmt::format("{:.3g}", value);
+        }
+    }
+
+    std::string sample::summary(std::size_t elements) const {
+
+        if (std::ranges::none_of(values, [](const auto& value) { return value.has_value(); }))
+            return "no counter values";
+
+        std::string result;
+        auto out = std::back_inserter(result);
+
+        if (auto value = ipc()) fmt::format_to(out, "IPC {:.2f}", *value);
+
+        for (std::size_t i = 0; i < event_count; i++) {
+            if (!values[i]) continue;
+            fmt::format_to(out, "{}{} {}", result.empty() ? "" : ", ", si(double(*values[i])), configs[i].name);
+        }
+
+        if (elements == 0) return result;
+
+        result += " |";
+        for (std::size_t i = 0, written = 0; i < event_count; i++) {
+            if (!values[i]) continue;
+            fmt::format_to(out, "{} {:.3g} {}", written++ ? "," : "", double(*values[i]) / double(elements), configs[i].name);
+        }
+        result += " per element";
+
+        return result;
+
+    }
+
+    counters::counters() {
+
+        m_Descriptors.fill(-1);
+
+        for (std::size_t i = 0; i < event_count; i++) {
+
+            int descriptor = open_event(configs[i], m_Leader);
+
+            if (descriptor < 0) {
+                if (m_Error.empty()) m_Error = fmt::format("can't open {}: {}", configs[i].name, std::strerror(errno));
+                continue;
+            }
+
+            if (m_Leader < 0) m_Leader = descriptor;
+            m_Descriptors[i] = descriptor;
+            ioctl(descriptor, PERF_EVENT_IOC_ID, &m_Ids[i]);
+        }
+
+    }
+
+    counters::~counters() {
+        for (int descriptor : m_Descriptors)
+            if (descriptor >= 0) close(descriptor);
+    }
+
+    void counters::start() {
+
+        if (available()) {
+            ioctl(m_Leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(m_Leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        m_Start = std::chrono::steady_clock::now();
+
+    }
+
+    sample counters::stop() {
+
+        auto end = std::chrono::steady_clock::now();
+
+        sample result;
+        result.elapsed = end - m_Start;
+
+        if (!available()) return result;
+
+        ioctl(m_Leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time enabled, time running, then a value and id pair per event
+        auto buffer = std::vector<uint64_t>(3 + 2 * event_count);
+        if (read(m_Leader, buffer.data(), buffer.size() * sizeof(uint64_t)) < 0) return result;
+
+        uint64_t count = buffer[0], enabled = buffer[1], running = buffer[2];
+
+        // The group never got onto the PMU
+        if (running == 0) return result;
+
+        double scale = double(enabled) / double(running);
+
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t value = buffer[3 + 2 * i], id = buffer[4 + 2 * i];
+            for (std::size_t e = 0; e < event_count; e++)
+                if (m_Descriptors[e] >= 0 && m_Ids[e] == id)
+                    result.values[e] = uint64_t(double(value) * scale);
+        }
+
+        return result;
+
+    }
+
+    scope::~scope() {
+
+        auto result = m_Counters.stop();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(result.elapsed).count();
+
+        std::cout << std::dec << m_Name << ": " << us << "us (" << us * 0.001 << "ms) | "
+            << (m_Counters.available() ? result.summary(m_Elements) : "counters unavailable, " + m_Counters.error()) << std::endl;
+
+    }
+}
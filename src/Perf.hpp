@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace RozeFoundUtils {
+
+	namespace perf {
+
+		enum class event : std::size_t {
+			cycles, instructions, cache_misses, branch_misses, llc_loads, count
+		};
+
+		inline constexpr std::size_t event_count = std::size_t(event::count);
+
+		// Counter values of one measurement, scaled up when the kernel had to
+		// multiplex the group. Events the machine can't count are left empty
+
+		struct sample {
+
+			std::chrono::nanoseconds elapsed {};
+			std::array<std::optional<uint64_t>, event_count> values {};
+
+			std::optional<uint64_t> operator[](event e) const noexcept { return values[std::size_t(e)]; }
+
+			std::optional<double> ipc() const noexcept {
+				auto cycles = (*this)[event::cycles], instructions = (*this)[event::instructions];
+				if (!cycles || !instructions || *cycles == 0) return std::nullopt;
+				return double(*instructions) / double(*cycles);
+			}
+
+			// e.g. "IPC 1.92, 3.1G cycles, 5.95G instructions, 12.4M cache misses", with
+			// elements followed by " | 3.1 cycles, 5.95 instructions, 0.0124 cache misses per element"
+			std::string summary(std::size_t elements = 0) const;
+		};
+
+		// One group of user-space counters for the calling thread, opened with
+		// perf_event_open. Reading the group is a single syscall, so all values
+		// come from the same window
+
+		class counters {
+
+		public:
+
+			// Constructors
+
+			counters();
+			counters(const counters&) = delete;
+			counters& operator=(const counters&) = delete;
+			~counters();
+
+			// Methods
+
+			// False when no event could be opened, e.g. perf_event_paranoid or a VM without a PMU
+			bool available() const noexcept { return m_Leader >= 0; }
+			const std::string& error() const noexcept { return m_Error; }
+
+			void start();
+			sample stop();
+
+		private:
+
+			// Local variables
+
+			int m_Leader = -1;
+			std::array<int, event_count> m_Descriptors;
+			std::array<uint64_t, event_count> m_Ids {};
+			std::string m_Error;
+
+			std::chrono::steady_clock::time_point m_Start;
+		};
+
+		// Counts the enclosing scope and prints it the way Timer does, plus the counters
+		class scope {
+
+		public:
+
+			// Constructors
+
+			explicit scope(std::string_view name, std::size_t elements = 0) : m_Name(name), m_Elements(elements) { m_Counters.start(); }
+			~scope();
+
+		private:
+
+			// Local variables
+
+			std::string_view m_Name;
+			std::size_t m_Elements;
+			counters m_Counters;
+		};
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Queue.hpp"
+#include "Trace.hpp"
+
+namespace RozeFoundUtils {
+
+	namespace detail {
+
+		struct pipeline_state {
+
+			std::vector<std::jthread> threads;
+
+			std::atomic<bool> failed = false;
+			std::exception_ptr error;
+			std::mutex mutex;
+
+			void fail() noexcept {
+				std::lock_guard lock(mutex);
+				if (!error) error = std::current_exception();
+				failed.store(true, std::memory_order_relaxed);
+			}
+
+			void join() {
+				for (auto& thread : threads) if (thread.joinable()) thread.join();
+				if (error) std::rethrow_exception(error);
+			}
+		};
+
+		template<typename T> struct optional_traits : std::false_type { using type = T; };
+		template<typename T> struct optional_traits<std::optional<T>> : std::true_type { using type = T; };
+
+		template<typename F, typename T> using stage_result_t =
+			typename optional_traits<std::remove_cvref_t<std::invoke_result_t<F&, T>>>::type;
+	}
+
+	// Chain of stages connected by bounded queues, every stage runs on its own
+	// workers as soon as it is added. A full queue blocks the stage feeding it,
+	// so a slow stage throttles everything upstream instead of buffering the dataset.
+	// Stages returning std::optional drop the items they return empty for.
+	// With more than one worker per stage items can come out in any order
+
+	template<typename T> class pipeline {
+
+	public:
+
+		using value_type = T;
+
+		// Constructors
+
+		pipeline(std::shared_ptr<detail::pipeline_state> state, std::shared_ptr<mpmc_queue<T>> output)
+			: m_State(std::move(state)), m_Output(std::move(output)) {}
+
+		pipeline(pipeline&&) noexcept = default;
+		pipeline& operator=(pipeline&&) noexcept = default;
+
+		// Dropped without a sink, the remaining output is drained and discarded
+		~pipeline() {
+			if (!m_State) return;
+			while (m_Output->pop());
+			m_State->threads.clear();
+		}
+
+		// Methods
+
+		template<typename F> auto then(F function, std::size_t workers = 1, std::size_t capacity = 256) && {
+
+			using U = detail::stage_result_t<F, T>;
+
+			auto output = std::make_shared<mpmc_queue<U>>(capacity);
+			auto remaining = std::make_shared<std::atomic<std::size_t>>(workers);
+
+			for (std::size_t i = 0; i < workers; i++)
+				m_State->threads.emplace_back([=, state = m_State.get(), input = m_Output] {
+
+					while (auto item = input->pop()) {
+
+						// After a failure everything upstream is drained without doing work
+						if (state->failed.load(std::memory_order_relaxed)) continue;
+
+						try {
+							SCOPED_ZONE("pipeline stage");
+							if constexpr (detail::optional_traits<std::invoke_result_t<F&, T>>::value) {
+								if (auto result = std::invoke(function, std::move(*item))) output->push(std::move(*result));
+							}
+							else output->push(std::invoke(function, std::move(*item)));
+						}
+						catch (...) { state->fail(); }
+					}
+
+					if (--*remaining == 0) output->close();
+				});
+
+			return pipeline<U>(std::exchange(m_State, {}), std::move(output));
+		}
+
+		// Runs function on every item that comes out of the last stage and waits for
+		// the whole pipeline, rethrows the first exception any stage threw
+		template<typename F> void for_each(F function, std::size_t workers = 1) && {
+
+			auto state = std::exchange(m_State, {});
+			auto input = m_Output;
+
+			for (std::size_t i = 1; i < workers; i++)
+				state->threads.emplace_back([&] {
+					while (auto item = input->pop()) {
+						if (state->failed.load(std::memory_order_relaxed)) continue;
+						try { std::invoke(function, std::move(*item)); }
+						catch (...) { state->fail(); }
+					}
+				});
+
+			while (auto item = input->pop()) {
+				if (state->failed.load(std::memory_order_relaxed)) continue;
+				try { std::invoke(function, std::move(*item)); }
+				catch (...) { state->fail(); }
+			}
+
+			state->join();
+		}
+
+		std::vector<T> collect() && {
+			std::vector<T> result;
+			std::move(*this).for_each([&](T item) { result.push_back(std::move(item)); });
+			return result;
+		}
+
+	private:
+
+		// Local variables
+
+		std::shared_ptr<detail::pipeline_state> m_State;
+		std::shared_ptr<mpmc_queue<T>> m_Output;
+	};
+
+	// Starts a pipeline with one thread feeding the elements of source into it.
+	// An lvalue source is referenced, not copied, and has to outlive the pipeline
+
+	template<std::ranges::input_range R> auto make_pipeline(R&& source, std::size_t capacity = 256) {
+
+		using T = std::ranges::range_value_t<R>;
+
+		auto state = std::make_shared<detail::pipeline_state>();
+		auto output = std::make_shared<mpmc_queue<T>>(capacity);
+
+		state->threads.emplace_back([view = std::views::all(std::forward<R>(source)), state = state.get(), output]() mutable {
+			try {
+				for (auto&& item : view) {
+					if (state->failed.load(std::memory_order_relaxed)) break;
+					output->push(T(std::forward<decltype(item)>(item)));
+				}
+			}
+			catch (...) { state->fail(); }
+			output->close();
+		});
+
+		return pipeline<T>(std::move(state), std::move(output));
+	}
+}
@@ -0,0 +1,724 @@
+#include "Primes.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RozeFoundUtils::primes {
+
+    namespace {
+
+        uint64_t iroot(uint64_t x, unsigned n) {
+
+            auto root = uint64_t(std::pow(double(x), 1.0 / n));
+
+            auto power = [n](uint64_t value) {
+                long double result = 1;
+                for (unsigned i = 0; i < n; i++) result *= value;
+                return result;
+            };
+
+            while (root > 0 && power(root) > x) root--;
+            while (power(root + 1) <= x) root++;
+
+            return root;
+        }
+
+        uint64_t odd_words(uint64_t limit) { return (limit / 2 + 1 + 63) / 64; }
+
+        // Odd-only segmented sieve over [0, limit], bit i stands for 2i + 1. Every
+        // segment is handed to on_segment(first_word, words) as soon as it's done
+
+        template<typename F> void sieve_odd(uint64_t limit, F&& on_segment) {
+
+            uint64_t odd_count = limit / 2 + 1;
+
+            uint32_t root = uint32_t(iroot(limit, 2));
+            auto base = bitset(root + 1, true);
+            for (uint32_t p = 2; p * p <= root; p++)
+                if (base.test(p)) base.reset_stride(p * p, p);
+
+            auto sieving = std::vector<uint32_t>();
+            for (uint32_t p = 3; p <= root; p += 2)
+                if (base.test(p)) sieving.push_back(p);
+
+            // A whole number of words, so every segment starts on a word boundary
+            constexpr uint64_t segment_size = 1 << 18;
+            auto segment = bitset();
+
+            for (uint64_t low = 0; low < odd_count; low += segment_size) {
+
+                uint64_t high = std::min(low + segment_size, odd_count);
+                segment.assign(high - low, true);
+
+                for (uint32_t p : sieving) {
+                    // First odd multiple of p that is at least p * p, as a bit index
+                    uint64_t start = uint64_t(p) * p / 2;
+                    if (start >= high) break;
+                    if (start < low) start = low + (p - (low - start) % p) % p;
+                    segment.reset_stride(start - low, p);
+                }
+
+                // The last bit stands for limit + 1 when limit is even, and 1 is not a prime
+                if (2 * (high - 1) + 1 > limit) segment.reset(high - 1 - low);
+                if (low == 0) segment.reset(0);
+
+                on_segment(low / 64, segment.words());
+            }
+        }
+
+        // phi(x, k) for the first k <= 6 primes, periodic with the primorial of those primes
+
+        class small_phi {
+
+        public:
+
+            small_phi() {
+
+                constexpr uint32_t small[] = { 2, 3, 5, 7, 11, 13 };
+
+                m_Products[0] = 1;
+                m_Tables[0] = { 0 };
+
+                for (size_t k = 1; k <= 6; k++) {
+
+                    m_Products[k] = m_Products[k - 1] * small[k - 1];
+                    auto& table = m_Tables[k];
+                    table.resize(m_Products[k]);
+
+                    for (uint32_t n = 1, count = 0; n < m_Products[k]; n++) {
+                        bool coprime = std::all_of(small, small + k, [n](uint32_t p) { return n % p != 0; });
+                        table[n] = count += coprime;
+                    }
+                }
+            }
+
+            uint64_t operator()(uint64_t x, size_t k) const {
+                if (k == 0) return x;
+                auto product = m_Products[k];
+                return x / product * m_Tables[k].back() + m_Tables[k][x % product];
+            }
+
+        private:
+
+            uint32_t m_Products[7];
+            std::vector<uint32_t> m_Tables[7];
+        };
+
+        // Lagarias-Miller-Odlyzko. With y a few times the cube root of x and a = pi(y),
+        // pi(x) = phi(x, a) + a - 1 - P2, P2 counting the n <= x made of two primes above y.
+        // Expanding phi(x, a) = phi(x, a - 1) - phi(x / p_a, a - 1) until the divisor passes y
+        // leaves ordinary leaves mu(n) phi(x / n, 6) with n <= y, and special leaves
+        // -mu(m) phi(x / (p_b m), b - 1) with m <= y < p_b m. Special leaves below both p_b^2
+        // and y are a pi lookup, the rest and the pi(x / p) of P2 are counted on a sieve of
+        // [0, x / y] whose segments are shared out between threads
+
+        class lmo {
+
+        public:
+
+            explicit lmo(uint64_t x) : m_X(x) {
+
+                // A larger y moves work from the sieve to the leaves, 4 is about the balance
+                uint64_t root = iroot(x, 2);
+                m_Y = std::min(4 * iroot(x, 3), root);
+                m_Z = x / m_Y;
+
+                // Smallest prime factor and Moebius function up to y
+                m_Lpf.assign(m_Y + 1, 0);
+                m_Mu.assign(m_Y + 1, 1);
+                m_Primes = { 0 };
+
+                for (uint64_t n = 2; n <= m_Y; n++) {
+
+                    if (m_Lpf[n]) continue;
+                    m_Primes.push_back(uint32_t(n));
+
+                    for (uint64_t i = n; i <= m_Y; i += n) {
+                        if (!m_Lpf[i]) m_Lpf[i] = uint32_t(n);
+                        m_Mu[i] = int8_t(-m_Mu[i]);
+                    }
+
+                    for (uint64_t i = n * n; i <= m_Y; i += n * n) m_Mu[i] = 0;
+                }
+
+                // 1 has no prime factor, so no bound on the smallest one
+                m_Lpf[1] = std::numeric_limits<uint32_t>::max();
+                m_A = m_Primes.size() - 1;
+
+                m_Pi.resize(m_Y + 1);
+                for (uint64_t n = 1, count = 0; n <= m_Y; n++) m_Pi[n] = uint32_t(count += m_Lpf[n] == n);
+
+                // The p of P2, ascending
+                sieve_odd(root, [&](uint64_t first_word, std::span<const uint64_t> words) {
+                    for (std::size_t i = 0; i < words.size(); i++)
+                        for (uint64_t bits = words[i]; bits; bits &= bits - 1) {
+                            uint64_t p = ((first_word + i) * 64 + std::countr_zero(bits)) * 2 + 1;
+                            if (p > m_Y) m_Large.push_back(uint32_t(p));
+                        }
+                });
+            }
+
+            uint64_t pi() const {
+
+                std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+                // Easy leaves, split by how many of them each b has
+                uint64_t first = std::max(small_count + 1, m_Pi[iroot(m_Y, 2)] + uint64_t(1));
+                auto easy_sums = std::vector<uint64_t>(threads);
+
+                if (first <= m_A) {
+                    partitioner parts(first, m_A + 1, threads, [&](std::size_t b) { return double(m_A - easy_start(b)); });
+                    parallel_chunks(parts, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+                        easy_sums[worker] += easy(begin, end);
+                    });
+                }
+
+                // Most hard leaves land in the first segments, so they go out one at a time from the front
+                uint64_t segments = m_Z / (2 * segment_bits) + 1;
+                auto tallies = std::vector<tally>(segments);
+                auto buffers = std::vector<scratch>(threads);
+
+                partitioner parts(0, segments, std::min<uint64_t>(threads, segments), schedule::dynamic);
+                parallel_chunks(parts, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+                    for (std::size_t index = begin; index < end; index++)
+                        tallies[index] = segment(index, buffers[worker]);
+                });
+
+                // Sums wrap around like everything else here, only the result has to fit
+                uint64_t sum = ordinary(), p2 = 0, before = 0;
+                for (uint64_t part : easy_sums) sum += part;
+
+                // phi(v, b - 1) of a leaf is what survived p_1 .. p_(b-1) before its segment plus inside it
+                auto phi = std::vector<uint64_t>(m_A + 1);
+
+                for (const auto& part : tallies) {
+
+                    sum += part.leaves;
+
+                    for (std::size_t i = 0; i < part.signs.size(); i++) {
+                        sum += uint64_t(part.signs[i]) * phi[i];
+                        phi[i] += part.counts[i];
+                    }
+
+                    // Everything that survived or was sieved out as a prime before the segment, less the 1
+                    p2 += part.p2 + part.targets * (before - 1);
+                    before += part.survivors + part.removed;
+                }
+
+                uint64_t last = m_A + m_Large.size();
+                p2 -= last * (last - 1) / 2 - m_A * (m_A - 1) / 2;
+
+                return sum + m_A - 1 - p2;
+            }
+
+        private:
+
+            // Primes 2 to 13 are taken care of by small_phi and the segment pattern
+            static constexpr uint64_t small_count = 6;
+
+            // Odd numbers per segment, a segment covers twice as many integers and fits in L1
+            static constexpr uint64_t segment_bits = 1 << 18;
+
+            // Survivors are kept per block, a count walks the blocks and then at most 8 words
+            static constexpr uint64_t block_bits = 512;
+
+            // What one segment adds up. Per b entries only go as far as the b that still have
+            // leaves in the segment, fewer and fewer of them further out
+            struct tally {
+                std::vector<uint64_t> counts;  // survivors of p_1 .. p_(b-1), from b = 7 on
+                std::vector<int64_t> signs;    // sum of -mu(m) over the leaves of p_b
+                uint64_t leaves = 0;           // leaves, counted inside the segment only
+                uint64_t targets = 0;          // x / p of P2 in the segment
+                uint64_t p2 = 0;               // their pi, counted inside the segment only
+                uint64_t survivors = 0;        // after all of the sieving
+                uint64_t removed = 0;          // primes sieved out of the segment
+            };
+
+            struct scratch {
+                std::vector<uint64_t> bits;
+                std::vector<uint32_t> counters;
+            };
+
+            // Odd numbers free of 3, 5, 7, 11 and 13, the period is 15015 odd numbers
+            static const std::vector<uint64_t>& pattern() {
+
+                static const auto result = [] {
+                    auto words = std::vector<uint64_t>(15015);
+                    for (uint64_t i = 0; i < words.size() * 64; i++) {
+                        uint64_t n = 2 * i + 1;
+                        if (n % 3 && n % 5 && n % 7 && n % 11 && n % 13) words[i / 64] |= uint64_t(1) << (i % 64);
+                    }
+                    return words;
+                }();
+
+                return result;
+            }
+
+            uint64_t ordinary() const {
+
+                uint64_t sum = 0;
+
+                for (uint64_t n = 1; n <= m_Y; n++) {
+                    if (!m_Mu[n] || m_Lpf[n] <= m_Primes[small_count]) continue;
+                    uint64_t phi = m_SmallPhi(m_X / n, small_count);
+                    sum += m_Mu[n] > 0 ? phi : -phi;
+                }
+
+                return sum;
+            }
+
+            // For p_b above the square root of y every m is a prime above p_b. Leaves below
+            // min(p_b^2, y + 1) are 1 and the primes from p_b to x / (p_b m), those come from
+            // the primes past index easy_start(b)
+            uint64_t easy_start(uint64_t b) const {
+                uint64_t p = m_Primes[b], bound = std::min(p * p, m_Y + 1);
+                uint64_t start = std::max({ p, m_Y / p, m_X / p / bound });
+                return start >= m_Y ? m_A : m_Pi[start];
+            }
+
+            uint64_t easy(uint64_t first, uint64_t last) const {
+
+                uint64_t sum = 0;
+
+                for (uint64_t b = first; b < last; b++) {
+                    uint64_t p = m_Primes[b], xp = m_X / p;
+                    for (uint64_t k = m_A; k > easy_start(b); k--) {
+                        uint64_t v = xp / m_Primes[k];
+                        sum += v >= p ? m_Pi[v] - b + 2 : 1;
+                    }
+                }
+
+                return sum;
+            }
+
+            tally segment(uint64_t index, scratch& buffers) const {
+
+                uint64_t low = index * 2 * segment_bits, high = std::min(low + 2 * segment_bits, m_Z + 1);
+                uint64_t size = (high - low) / 2;
+
+                // Bit i stands for low + 2i + 1
+                auto& bits = buffers.bits;
+                auto& counters = buffers.counters;
+                bits.resize(segment_bits / 64);
+                counters.resize(segment_bits / block_bits);
+
+                const auto& wheel = pattern();
+                for (uint64_t word = 0, first = low / 128; word < bits.size(); word++)
+                    bits[word] = wheel[(first + word) % wheel.size()];
+
+                if (size < segment_bits) {
+                    bits[size / 64] &= (uint64_t(1) << (size % 64)) - 1;
+                    std::fill(bits.begin() + size / 64 + 1, bits.end(), 0);
+                }
+
+                uint64_t survivors = 0;
+                for (uint64_t block = 0; block < counters.size(); block++)
+                    {
+                    uint32_t set = 0;
+                    for (uint64_t word = block * block_bits / 64; word < (block + 1) * block_bits / 64; word++) set += std::popcount(bits[word]);
+                    survivors += counters[block] = set;
+                }
+
+                auto remove = [&](uint64_t i) {
+                    uint64_t word = bits[i / 64], bit = word >> (i % 64) & 1;
+                    bits[i / 64] = word & ~(uint64_t(1) << (i % 64));
+                    counters[i / block_bits] -= uint32_t(bit);
+                    survivors -= bit;
+                };
+
+                // Survivors from low to v, for v that only go up between resets
+                uint64_t block = 0, passed = 0;
+                auto count = [&](uint64_t v) {
+                    uint64_t n = (v - low + 1) / 2;
+                    for (; (block + 1) * block_bits <= n; block++) passed += counters[block];
+                    uint64_t result = passed;
+                    for (uint64_t word = block * block_bits / 64; word < n / 64; word++) result += std::popcount(bits[word]);
+                    if (n % 64) result += std::popcount(bits[n / 64] & ((uint64_t(1) << (n % 64)) - 1));
+                    return result;
+                };
+
+                tally result;
+                if (low == 0) result.removed = small_count;
+
+                // Composites up to high all have a factor up to its square root
+                uint64_t sieve_end = m_Pi[std::min(m_Y, iroot(high - 1, 2))];
+                bool leaves = true;
+
+                for (uint64_t b = small_count + 1; b <= m_A; b++) {
+
+                    uint64_t p = m_Primes[b], xp = m_X / p;
+
+                    if (leaves) {
+
+                        // Leaves x / (p m) in the segment have most >= m > fewest, and m > p
+                        uint64_t most = low == 0 ? m_Y : std::min(m_Y, xp / low);
+                        uint64_t fewest = std::max(m_Y / p, xp / high);
+
+                        // Leaves thin out with b, once there are none there are none further on
+                        leaves = most > p;
+
+                        if (leaves) {
+
+                            uint64_t sum = 0;
+                            int64_t sign = 0;
+                            block = passed = 0;
+
+                            if (p * p > m_Y) {
+                                // Primes only, the easy leaves below min(p^2, y + 1) were done apart
+                                uint64_t start = std::max(p, fewest), end = std::min(most, xp / std::min(p * p, m_Y + 1));
+                                if (end > start)
+                                    for (uint64_t k = m_Pi[end]; k > m_Pi[start]; k--, sign++) sum += count(xp / m_Primes[k]);
+                            } else {
+                                for (uint64_t m = most; m > fewest; m--) {
+                                    if (!m_Mu[m] || m_Lpf[m] <= p) continue;
+                                    uint64_t phi = count(xp / m);
+                                    sum += m_Mu[m] > 0 ? -phi : phi;
+                                    sign -= m_Mu[m];
+                                }
+                            }
+
+                            result.leaves += sum;
+                            result.signs.push_back(sign);
+                            result.counts.push_back(survivors);
+                        }
+                    }
+
+                    if (!leaves && b > sieve_end) break;
+
+                    // Every multiple of p goes, p included, as phi counts numbers free of it
+                    if (p * p < high) {
+                        uint64_t first = std::max(p, (low + p - 1) / p * p);
+                        if (first % 2 == 0) first += p;
+                        for (uint64_t i = (first - low) / 2; i < size; i += p) remove(i);
+                    } else if (p >= low && p < high) {
+                        remove((p - low) / 2);
+                    }
+
+                    result.removed += p >= low && p < high;
+                }
+
+                result.survivors = survivors;
+
+                // pi(x / p) for the p of P2 whose x / p is in the segment, largest p first
+                auto from = std::upper_bound(m_Large.begin(), m_Large.end(), m_X / high);
+                auto to = low == 0 ? m_Large.end() : std::upper_bound(m_Large.begin(), m_Large.end(), m_X / low);
+                block = passed = 0;
+
+                // Every prime sieved out is below y and so below any x / p
+                for (auto it = to; it != from; result.targets++)
+                    result.p2 += count(m_X / *--it) + result.removed;
+
+                return result;
+            }
+
+            uint64_t m_X;
+            uint64_t m_Y;
+            uint64_t m_Z;
+            uint64_t m_A;
+
+            std::vector<uint32_t> m_Primes;
+            std::vector<uint32_t> m_Lpf;
+            std::vector<int8_t> m_Mu;
+            std::vector<uint32_t> m_Pi;
+            std::vector<uint32_t> m_Large;
+
+            small_phi m_SmallPhi;
+        };
+    }
+
+    uint64_t prime_pi(uint64_t x) {
+
+        if (x < table_bound) return count_primes(x + 1);
+
+        return lmo(x).pi();
+
+    }
+
+    void write_bitmap(const std::filesystem::path& path, uint64_t limit, uint32_t rank_interval) {
+
+        if (rank_interval == 0) throw std::invalid_argument("rank interval must be positive");
+
+        bitmap_header header = { { 'R', 'F', 'P', 'R', 'I', 'M', 'E', 'S' }, 1, rank_interval, limit };
+        header.word_count = odd_words(limit);
+        header.bits_offset = sizeof(bitmap_header);
+        header.rank_offset = header.bits_offset + header.word_count * sizeof(uint64_t);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("Can't open bitmap file for writing");
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        auto ranks = std::vector<uint64_t>();
+        ranks.reserve(header.word_count / rank_interval + 1);
+
+        uint64_t count = 0;
+
+        sieve_odd(limit, [&](uint64_t first_word, std::span<const uint64_t> words) {
+
+            for (std::size_t i = 0; i < words.size(); i++) {
+                if ((first_word + i) % rank_interval == 0) ranks.push_back(count);
+                count += std::popcount(words[i]);
+            }
+
+            file.write(reinterpret_cast<const char*>(words.data()), words.size_bytes());
+        });
+
+        file.write(reinterpret_cast<const char*>(ranks.data()), ranks.size() * sizeof(uint64_t));
+
+        // Odd primes were counted, 2 is implied
+        header.prime_count = count + (limit >= 2);
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        if (!file) throw std::runtime_error("Failed to write bitmap file");
+
+    }
+
+    bitmap::bitmap(const std::filesystem::path& path) {
+
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) throw std::runtime_error("File is not found");
+
+        struct stat info;
+        if (::fstat(descriptor, &info) != 0 || std::size_t(info.st_size) < sizeof(bitmap_header)) {
+            ::close(descriptor);
+            throw std::runtime_error("Not a prime bitmap file");
+        }
+
+        m_Size = info.st_size;
+        void* mapping = ::mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+
+        if (mapping == MAP_FAILED) throw std::runtime_error("Failed to map bitmap file");
+        m_Mapping = mapping;
+
+        auto bytes = static_cast<const std::byte*>(m_Mapping);
+        m_Header = reinterpret_cast<const bitmap_header*>(bytes);
+
+        bool valid = std::memcmp(m_Header->magic, "RFPRIMES", 8) == 0 && m_Header->version == 1 && m_Header->rank_interval > 0;
+
+        if (valid) {
+            auto rank_count = (m_Header->word_count + m_Header->rank_interval - 1) / m_Header->rank_interval;
+            valid = m_Header->rank_offset + rank_count * sizeof(uint64_t) <= m_Size
+                && m_Header->bits_offset + m_Header->word_count * sizeof(uint64_t) <= m_Header->rank_offset;
+        }
+
+        if (!valid) {
+            unmap();
+            throw std::runtime_error("Not a prime bitmap file");
+        }
+
+        m_Bits = reinterpret_cast<const uint64_t*>(bytes + m_Header->bits_offset);
+        m_Ranks = reinterpret_cast<const uint64_t*>(bytes + m_Header->rank_offset);
+
+        ::madvise(mapping, m_Size, MADV_RANDOM);
+
+    }
+
+    bitmap::bitmap(bitmap&& other) noexcept { *this = std::move(other); }
+
+    bitmap& bitmap::operator=(bitmap&& other) noexcept {
+
+        if (this != &other) {
+            unmap();
+            m_Mapping = std::exchange(other.m_Mapping, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+            m_Header = std::exchange(other.m_Header, nullptr);
+            m_Bits = std::exchange(other.m_Bits, nullptr);
+            m_Ranks = std::exchange(other.m_Ranks, nullptr);
+        }
+
+        return *this;
+
+    }
+
+    bitmap::~bitmap() { unmap(); }
+
+    void bitmap::unmap() noexcept {
+        if (m_Mapping) ::munmap(const_cast<void*>(m_Mapping), m_Size);
+        m_Mapping = nullptr;
+    }
+
+    bool bitmap::is_prime(uint64_t n) const {
+
+        if (n > limit()) throw std::out_of_range("Number is past the bitmap limit");
+        if (n == 2) return true;
+        if (n % 2 == 0) return false;
+
+        uint64_t index = n / 2;
+        return m_Bits[index / 64] >> (index % 64) & 1;
+
+    }
+
+    uint64_t bitmap::pi(uint64_t n) const {
+
+        if (n > limit()) throw std::out_of_range("Number is past the bitmap limit");
+        if (n < 2) return 0;
+
+        uint64_t index = (n - 1) / 2, word = index / 64;
+        uint64_t block = word / m_Header->rank_interval;
+
+        uint64_t count = 1 + m_Ranks[block];
+        for (uint64_t i = block * m_Header->rank_interval; i < word; i++)
+            count += std::popcount(m_Bits[i]);
+
+        return count + std::popcount(m_Bits[word] & (~uint64_t(0) >> (63 - index % 64)));
+
+    }
+
+    uint64_t bitmap::nth_prime(uint64_t k) const {
+
+        if (k == 0 || k > count()) throw std::out_of_range("Bitmap holds fewer primes");
+        if (k == 1) return 2;
+
+        // Rank among odd primes, 1-based
+        uint64_t rank = k - 1;
+        uint64_t rank_count = (m_Header->word_count + m_Header->rank_interval - 1) / m_Header->rank_interval;
+
+        // Last block starting with fewer than rank primes before it
+        uint64_t block = std::partition_point(m_Ranks, m_Ranks + rank_count, [&](uint64_t before) { return before < rank; }) - m_Ranks - 1;
+        uint64_t seen = m_Ranks[block];
+
+        for (uint64_t word = block * m_Header->rank_interval; word < m_Header->word_count; word++) {
+
+            uint64_t bits = m_Bits[word];
+            uint64_t count = std::popcount(bits);
+
+            if (seen + count >= rank) {
+                for (uint64_t skip = rank - seen - 1; skip > 0; skip--) bits &= bits - 1;
+                return (word * 64 + std::countr_zero(bits)) * 2 + 1;
+            }
+
+            seen += count;
+        }
+
+        throw std::out_of_range("Bitmap holds fewer primes");
+
+    }
+
+    prime_generator::prime_generator(uint64_t from, uint64_t to)
+        : m_Low(from / 2), m_High(from / 2), m_End(std::max(from / 2, to / 2)), m_Two(from <= 2 && to > 2) {
+
+        // The first odd index is 1, the number 1 is not a prime
+        m_Low = m_High = std::max<uint64_t>(m_High, 1);
+        m_End = std::max(m_End, m_High);
+
+    }
+
+    std::size_t prime_generator::next_batch(std::span<uint64_t> out) {
+
+        std::size_t count = 0;
+
+        if (m_Two && !out.empty()) {
+            out[count++] = 2;
+            m_Two = false;
+        }
+
+        while (count < out.size()) {
+
+            if (m_Bits == 0) {
+                if (m_Word + 1 < m_Window.words().size()) m_Bits = m_Window.words()[++m_Word];
+                else if (!advance()) break;
+                continue;
+            }
+
+            out[count++] = 2 * (m_Low + m_Word * 64 + std::countr_zero(m_Bits)) + 1;
+            m_Bits &= m_Bits - 1;
+        }
+
+        return count;
+
+    }
+
+    std::optional<uint64_t> prime_generator::next() {
+
+        uint64_t value;
+        if (next_batch(std::span(&value, 1)) == 0) return std::nullopt;
+
+        return value;
+
+    }
+
+    bool prime_generator::advance() {
+
+        // 2^18 bits is 32KB, the window stays in L1 or L2 while it is marked
+        constexpr uint64_t window_size = 1 << 18;
+
+        if (m_High >= m_End) return false;
+
+        m_Low = m_High;
+        m_High = m_Low + std::min(window_size, m_End - m_Low);
+
+        extend_sieving(iroot(2 * m_High - 1, 2));
+
+        m_Window.assign(m_High - m_Low, true);
+
+        for (std::size_t k = 0; k < m_Sieving.size(); k++) {
+
+            uint64_t p = m_Sieving[k];
+
+            // p * p lies past the window, and so does everything after it
+            if (p * p / 2 >= m_High) break;
+
+            uint64_t& next = m_Next[k];
+            if (next < m_Low) {
+                uint64_t start = p * p / 2;
+                next = start >= m_Low ? start : m_Low + (p - (m_Low - start) % p) % p;
+            }
+
+            m_Window.reset_stride(next - m_Low, p);
+            next += (m_High - next + p - 1) / p * p;
+        }
+
+        m_Word = 0;
+        m_Bits = m_Window.words().empty() ? 0 : m_Window.words()[0];
+
+        return true;
+
+    }
+
+    void prime_generator::extend_sieving(uint64_t root) {
+
+        if (root <= m_Root) return;
+
+        // Roots stay below 2^32, so the compile-time table holds every prime the extension
+        // needs. Sieved in pieces, far out the new roots alone span billions of numbers
+        constexpr uint64_t piece = 1 << 20;
+        auto segment = bitset();
+
+        for (uint64_t low = m_Root + 1; low <= root; low += piece) {
+
+            uint64_t high = std::min(low + piece - 1, root);
+            segment.assign(high - low + 1, true);
+
+            for (uint64_t p : table<table_bound>) {
+                if (p * p > high) break;
+                uint64_t start = std::max(p * p, (low + p - 1) / p * p);
+                if (start <= high) segment.reset_stride(start - low, p);
+            }
+
+            for (uint64_t n = std::max<uint64_t>(low | 1, 3); n <= high; n += 2)
+                if (segment.test(n - low)) {
+                    m_Sieving.push_back(uint32_t(n));
+                    m_Next.push_back(0);
+                }
+        }
+
+        m_Root = root;
+
+    }
+}
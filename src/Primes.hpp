@@ -0,0 +1,269 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Bitset.hpp"
+
+namespace RozeFoundUtils {
+
+	namespace primes {
+
+		// Bound of the tables generated at compile time, numbers below it are
+		// answered by lookup and its primes drive trial division above it
+		inline constexpr std::size_t table_bound = 1 << 16;
+
+		namespace detail {
+
+			template<std::size_t Bound> consteval auto sieve() {
+
+				std::array<bool, Bound> composite = {};
+				composite[0] = composite[1] = true;
+
+				for (std::size_t p = 2; p * p < Bound; p++)
+					if (!composite[p]) for (std::size_t i = p * p; i < Bound; i += p)
+						composite[i] = true;
+
+				return composite;
+			}
+
+			template<std::size_t Bound> consteval std::size_t count_below() {
+				std::size_t count = 0;
+				for (bool composite : sieve<Bound>()) count += !composite;
+				return count;
+			}
+
+			// Flags of numbers coprime to 2*3*5*7, repeated until it fills whole words
+			consteval auto wheel_pattern() {
+
+				constexpr std::size_t period = 210 * 32;
+				std::array<uint64_t, period / 64> pattern = {};
+
+				for (std::size_t n = 0; n < period; n++)
+					if (n % 2 && n % 3 && n % 5 && n % 7)
+						pattern[n / 64] |= uint64_t(1) << (n % 64);
+
+				return pattern;
+			}
+		}
+
+		// Every prime below Bound, in ascending order
+		template<std::size_t Bound> inline constexpr auto table = [] {
+
+			std::array<uint32_t, detail::count_below<Bound>()> result = {};
+
+			auto composite = detail::sieve<Bound>();
+			for (std::size_t n = 0, i = 0; n < Bound; n++)
+				if (!composite[n]) result[i++] = uint32_t(n);
+
+			return result;
+		}();
+
+		// Bit n is set when n is a prime below Bound
+		template<std::size_t Bound> inline constexpr auto bits = [] {
+
+			std::array<uint64_t, (Bound + 63) / 64> result = {};
+
+			auto composite = detail::sieve<Bound>();
+			for (std::size_t n = 0; n < Bound; n++)
+				if (!composite[n]) result[n / 64] |= uint64_t(1) << (n % 64);
+
+			return result;
+		}();
+
+		inline constexpr auto wheel_pattern = detail::wheel_pattern();
+
+		constexpr bool is_prime(std::integral auto n) {
+
+			if (n < 2) return false;
+
+			auto value = uint64_t(n);
+
+			if (value < table_bound)
+				return bits<table_bound>[value / 64] >> (value % 64) & 1;
+
+			for (uint64_t p : table<table_bound>) {
+				if (p * p > value) return true;
+				if (value % p == 0) return false;
+			}
+
+			// Past the table only numbers of the form 6k +- 1 can be prime divisors.
+			// i <= value / i rather than i * i <= value, the square wraps near 2^64
+			for (uint64_t i = table_bound - table_bound % 6 - 1; i <= value / i; i += 6)
+				if (value % i == 0 || value % (i + 2) == 0) return false;
+
+			return true;
+		}
+
+		// Number of primes below range
+		constexpr std::size_t count_primes(std::size_t range) {
+
+			if (range < table_bound) {
+				std::size_t count = 0;
+				for (auto p : table<table_bound>) count += p < range;
+				return count;
+			}
+
+			// Pre-sieved by the wheel pattern, so sieving starts at 11
+			auto sieve = bitset(range);
+			sieve.assign_pattern(wheel_pattern);
+
+			// 1 is out, 2, 3, 5 and 7 are back in
+			sieve.reset(1);
+			for (std::size_t p : { 2, 3, 5, 7 }) sieve.set(p);
+
+			for (std::size_t p = 11; p * p < range; p += 2)
+				if (sieve.test(p)) sieve.reset_stride(p * p, 2 * p);
+
+			return sieve.count();
+		}
+
+		// Number of primes not exceeding x, by the Lagarias-Miller-Odlyzko method in about
+		// x^(2/3) steps shared out between all hardware threads. Tables grow with the cube
+		// root of x, plus the primes up to its square root. pi(1e15) is about 8 s on one core
+		uint64_t prime_pi(uint64_t x);
+
+		// Primes in [from, to) in ascending order, sieved one window at a time. Only the
+		// window and the sieving primes up to the square root of the current window are
+		// kept, so memory stays O(sqrt(n)) however far it runs. Usable as a range or in batches
+
+		class prime_generator {
+
+		public:
+
+			class iterator {
+
+			public:
+
+				using value_type = uint64_t;
+				using difference_type = std::ptrdiff_t;
+
+				iterator() = default;
+				explicit iterator(prime_generator* generator) : m_Generator(generator) { ++*this; }
+
+				uint64_t operator*() const noexcept { return m_Value; }
+
+				iterator& operator++() {
+					auto value = m_Generator->next();
+					if (value) m_Value = *value;
+					else m_Generator = nullptr;
+					return *this;
+				}
+
+				void operator++(int) { ++*this; }
+
+				bool operator==(std::default_sentinel_t) const noexcept { return !m_Generator; }
+
+			private:
+
+				prime_generator* m_Generator = nullptr;
+				uint64_t m_Value = 0;
+			};
+
+			// Constructors
+
+			explicit prime_generator(uint64_t from = 0, uint64_t to = std::numeric_limits<uint64_t>::max());
+
+			// Methods
+
+			// Fills the front of out with the next primes, fewer only at the end of the range
+			std::size_t next_batch(std::span<uint64_t> out);
+
+			std::optional<uint64_t> next();
+
+			// Single pass, begin() carries on from wherever the generator is
+			iterator begin() { return iterator(this); }
+			std::default_sentinel_t end() const noexcept { return {}; }
+
+		private:
+
+			// Local methods
+
+			bool advance();
+			void extend_sieving(uint64_t root);
+
+			// Local variables
+
+			// Window over odd numbers, bit i stands for 2 * (m_Low + i) + 1
+			uint64_t m_Low;
+			uint64_t m_High;
+			uint64_t m_End;
+			bitset m_Window;
+
+			std::size_t m_Word = 0;
+			uint64_t m_Bits = 0;
+			bool m_Two;
+
+			// Odd sieving primes, the next multiple of each as an odd index, and how far they go
+			std::vector<uint32_t> m_Sieving;
+			std::vector<uint64_t> m_Next;
+			uint64_t m_Root = 2;
+		};
+
+		// On-disk odd-only prime bitmap: a fixed header, one bit per odd number up to
+		// the limit and a rank index holding the prime count before every block of words
+
+		struct bitmap_header {
+			char magic[8];
+			uint32_t version;
+			uint32_t rank_interval;
+			uint64_t limit;
+			uint64_t word_count;
+			uint64_t bits_offset;
+			uint64_t rank_offset;
+			uint64_t prime_count;
+			uint64_t reserved;
+		};
+
+		static_assert(sizeof(bitmap_header) == 64);
+
+		// Sieves [0, limit] segment by segment straight into the file, memory stays O(sqrt(limit))
+		void write_bitmap(const std::filesystem::path& path, uint64_t limit, uint32_t rank_interval = 8);
+
+		// Read-only memory mapped view of a bitmap file
+		class bitmap {
+
+		public:
+
+			// Constructors
+
+			explicit bitmap(const std::filesystem::path& path);
+			bitmap(bitmap&& other) noexcept;
+			bitmap& operator=(bitmap&& other) noexcept;
+			~bitmap();
+
+			// Methods
+
+			uint64_t limit() const noexcept { return m_Header->limit; }
+			uint64_t count() const noexcept { return m_Header->prime_count; }
+
+			bool is_prime(uint64_t n) const;
+
+			// Primes not exceeding n
+			uint64_t pi(uint64_t n) const;
+
+			// k-th prime counting from nth_prime(1) == 2
+			uint64_t nth_prime(uint64_t k) const;
+
+		private:
+
+			void unmap() noexcept;
+
+			const void* m_Mapping = nullptr;
+			std::size_t m_Size = 0;
+
+			const bitmap_header* m_Header = nullptr;
+			const uint64_t* m_Bits = nullptr;
+			const uint64_t* m_Ranks = nullptr;
+		};
+	}
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace RozeFoundUtils {
+
+	namespace detail {
+
+		// Spins briefly, then gives the core away a bounded number of times so a full or
+		// empty queue doesn't starve its peers. False once both are used up, time to block
+		class backoff {
+
+		public:
+
+			bool operator()() noexcept {
+				if (m_Spins < 64) {
+					for (unsigned i = 0; i < (1u << (m_Spins / 16)); i++) {
+#if defined(__x86_64__) || defined(__i386__)
+						_mm_pause();
+#endif
+					}
+					m_Spins++;
+				} else if (m_Yields < 64) {
+					std::this_thread::yield();
+					m_Yields++;
+				} else {
+					return false;
+				}
+				return true;
+			}
+
+		private:
+
+			unsigned m_Spins = 0;
+			unsigned m_Yields = 0;
+		};
+	}
+
+	// Bounded lock-free multi-producer multi-consumer queue. Every cell carries a
+	// sequence number telling producers and consumers whose turn it is, so each
+	// side only contends on its own counter. Capacity is rounded up to a power of two
+
+	template<typename T> class mpmc_queue {
+
+	public:
+
+		// Constructors
+
+		explicit mpmc_queue(std::size_t capacity) : m_Mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1) {
+			m_Cells = std::make_unique<cell[]>(m_Mask + 1);
+			for (std::size_t i = 0; i <= m_Mask; i++) m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		~mpmc_queue() { while (try_pop()); }
+
+		// Methods
+
+		std::size_t capacity() const noexcept { return m_Mask + 1; }
+
+		template<typename... Args> bool try_emplace(Args&&... args) {
+
+			auto position = m_Tail.load(std::memory_order_relaxed);
+
+			while (true) {
+
+				auto& slot = m_Cells[position & m_Mask];
+				auto sequence = slot.sequence.load(std::memory_order_acquire);
+				auto difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+
+				if (difference == 0) {
+					if (m_Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						::new (slot.storage) T(std::forward<Args>(args)...);
+						slot.sequence.store(position + 1, std::memory_order_release);
+						wake();
+						return true;
+					}
+				}
+				else if (difference < 0) return false;
+				else position = m_Tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		bool try_push(T value) { return try_emplace(std::move(value)); }
+
+		std::optional<T> try_pop() {
+
+			auto position = m_Head.load(std::memory_order_relaxed);
+
+			while (true) {
+
+				auto& slot = m_Cells[position & m_Mask];
+				auto sequence = slot.sequence.load(std::memory_order_acquire);
+				auto difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position + 1);
+
+				if (difference == 0) {
+					if (m_Head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						auto* item = std::launder(reinterpret_cast<T*>(slot.storage));
+						std::optional<T> result(std::move(*item));
+						item->~T();
+						slot.sequence.store(position + m_Mask + 1, std::memory_order_release);
+						wake();
+						return result;
+					}
+				}
+				else if (difference < 0) return std::nullopt;
+				else position = m_Head.load(std::memory_order_relaxed);
+			}
+		}
+
+		// Waits for space, this is the backpressure. False once the queue is closed
+		bool push(T value) {
+			bool pushed = false;
+			wait_until([&] { return closed() || (pushed = try_emplace(std::move(value))); });
+			return pushed;
+		}
+
+		// Waits for an item, empty once the queue is closed and drained
+		std::optional<T> pop() {
+			std::optional<T> item;
+			wait_until([&] {
+				if ((item = try_pop())) return true;
+				if (!closed()) return false;
+				item = try_pop();
+				return true;
+			});
+			return item;
+		}
+
+		// No more pushes, consumers drain what is left
+		void close() noexcept {
+			m_Closed.store(true, std::memory_order_release);
+			m_Epoch.fetch_add(2, std::memory_order_release);
+			m_Epoch.notify_all();
+		}
+
+		bool closed() const noexcept { return m_Closed.load(std::memory_order_acquire); }
+
+	private:
+
+		struct cell {
+			std::atomic<std::size_t> sequence;
+			alignas(T) std::byte storage[sizeof(T)];
+		};
+
+		// Local methods
+
+		// Retries attempt until it returns true, blocking on m_Epoch once the backoff runs out.
+		// The low bit of the epoch says someone is about to sleep: it is set before the last
+		// attempt and wake() checks it after every push or pop, with a full fence on both
+		// sides one of them sees the other. Only the waker that clears it makes the syscall
+		template<typename F> void wait_until(F attempt) {
+
+			for (detail::backoff wait; !attempt(); ) {
+
+				if (wait()) continue;
+
+				m_Epoch.fetch_or(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				auto epoch = m_Epoch.load(std::memory_order_acquire);
+				if (attempt()) return;
+				m_Epoch.wait(epoch, std::memory_order_acquire);
+			}
+		}
+
+		void wake() noexcept {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto epoch = m_Epoch.load(std::memory_order_relaxed);
+			if ((epoch & 1) && m_Epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_release, std::memory_order_relaxed))
+				m_Epoch.notify_all();
+		}
+
+		// Local variables
+
+		std::size_t m_Mask;
+		std::unique_ptr<cell[]> m_Cells;
+
+		alignas(64) std::atomic<std::size_t> m_Tail = 0;
+		alignas(64) std::atomic<std::size_t> m_Head = 0;
+		alignas(64) std::atomic<bool> m_Closed = false;
+
+		// Changes whenever a blocked thread may be able to go on, the low bit is set while one waits
+		alignas(64) std::atomic<uint32_t> m_Epoch = 0;
+	};
+}
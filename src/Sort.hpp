@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Utils.hpp"
+
+namespace RozeFoundUtils {
+
+	namespace detail::radix {
+
+		template<typename K> concept key = (std::integral<K> || std::floating_point<K>)
+			&& !std::same_as<K, bool> && sizeof(K) <= 8;
+
+		template<std::size_t Size> using bits_t =
+			std::conditional_t<Size == 1, uint8_t,
+			std::conditional_t<Size == 2, uint16_t,
+			std::conditional_t<Size == 4, uint32_t, uint64_t>>>;
+
+		// Maps a key onto an unsigned integer with the same ordering
+
+		template<key K> constexpr auto to_unsigned(K value) noexcept {
+
+			using U = bits_t<sizeof(K)>;
+			constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+
+			if constexpr (std::unsigned_integral<K>) return U(value);
+			else if constexpr (std::signed_integral<K>) return U(U(value) ^ sign);
+			else {
+				U bits = std::bit_cast<U>(value);
+				return U(bits & sign ? ~bits : bits | sign);
+			}
+		}
+
+		using histogram = std::array<std::size_t, 256>;
+
+		constexpr std::size_t line_size = 64;
+
+		// Scattered writes land on 256 different lines, a write prefetch hides the miss
+		template<typename T> void prefetch(const T* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(address, 1);
+#endif
+		}
+
+		constexpr std::size_t prefetch_distance = 16;
+
+		// Elements small enough to batch are staged per digit in cache line sized
+		// buffers and written out a full line at a time
+
+		template<typename T> constexpr bool write_combine = std::is_trivially_copyable_v<T> && sizeof(T) <= line_size / 2;
+
+		template<typename T, typename Key>
+		void scatter(T* from, T* to, std::size_t size, histogram& offsets, unsigned shift, Key& key) {
+
+			if constexpr (write_combine<T>) {
+
+				constexpr std::size_t batch = line_size / sizeof(T);
+
+				alignas(line_size) std::byte buffers[256][batch * sizeof(T)];
+				std::array<uint8_t, 256> fill = {};
+
+				for (std::size_t i = 0; i < size; i++) {
+
+					auto digit = (to_unsigned(std::invoke(key, from[i])) >> shift) & 0xFF;
+					std::memcpy(buffers[digit] + fill[digit] * sizeof(T), from + i, sizeof(T));
+
+					// Halfway to a flush the destination line is requested, so the
+					// full-line write doesn't stall on it
+					if (++fill[digit] == batch / 2) prefetch(to + offsets[digit]);
+
+					if (fill[digit] == batch) {
+						std::memcpy(to + offsets[digit], buffers[digit], sizeof(buffers[digit]));
+						offsets[digit] += batch;
+						fill[digit] = 0;
+					}
+				}
+
+				for (std::size_t digit = 0; digit < 256; digit++)
+					std::memcpy(to + offsets[digit], buffers[digit], fill[digit] * sizeof(T));
+
+			} else {
+				for (std::size_t i = 0; i < size; i++) {
+
+					// Where an element a few places on will go is known from the
+					// offsets already, its line is requested before it's needed
+					if (i + prefetch_distance < size)
+						prefetch(to + offsets[(to_unsigned(std::invoke(key, from[i + prefetch_distance])) >> shift) & 0xFF]);
+
+					auto digit = (to_unsigned(std::invoke(key, from[i])) >> shift) & 0xFF;
+					to[offsets[digit]++] = std::move(from[i]);
+				}
+			}
+		}
+
+		// Sorts by the low `bytes` bytes of the key, ping-ponging between data and
+		// scratch, returns whichever of the two ends up holding the result
+
+		template<typename T, typename Key>
+		T* lsd(T* data, T* scratch, std::size_t size, Key& key, std::size_t bytes) {
+
+			// All histograms are built in a single read pass
+			auto counts = std::vector<histogram>(bytes);
+
+			for (std::size_t i = 0; i < size; i++) {
+				auto value = to_unsigned(std::invoke(key, data[i]));
+				for (std::size_t byte = 0; byte < bytes; byte++)
+					counts[byte][(value >> (byte * 8)) & 0xFF]++;
+			}
+
+			T* from = data; T* to = scratch;
+
+			for (std::size_t byte = 0; byte < bytes; byte++) {
+
+				auto& count = counts[byte];
+				unsigned shift = unsigned(byte * 8);
+
+				// Every key shares this digit, the pass wouldn't move anything
+				if (count[(to_unsigned(std::invoke(key, from[0])) >> shift) & 0xFF] == size) continue;
+
+				histogram offsets;
+				for (std::size_t digit = 0, offset = 0; digit < 256; digit++) {
+					offsets[digit] = offset;
+					offset += count[digit];
+				}
+
+				scatter(from, to, size, offsets, shift, key);
+				std::swap(from, to);
+			}
+
+			return from;
+		}
+	}
+
+	// Stable LSD radix sort over 8-bit digits of an integer or IEEE float key,
+	// key is a projection so structs can be sorted by one of their members.
+	// With parallel set, a multi-threaded MSD pass on the top byte splits the
+	// input into 256 buckets first, each finished with LSD on its own thread
+
+	template<std::ranges::contiguous_range R, typename Key = std::identity>
+		requires detail::radix::key<std::remove_cvref_t<std::invoke_result_t<Key&, std::ranges::range_reference_t<R>>>>
+	void radix_sort(R&& range, Key key = {}, bool parallel = false) {
+
+		namespace radix = detail::radix;
+
+		using T = std::ranges::range_value_t<R>;
+		using K = std::remove_cvref_t<std::invoke_result_t<Key&, T&>>;
+
+		T* data = std::ranges::data(range);
+		std::size_t size = std::ranges::size(range);
+
+		if (size < 2) return;
+
+		// Every slot is written before it is read, no point zeroing it first
+		auto scratch = std::make_unique_for_overwrite<T[]>(size);
+
+		std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+		if (!parallel || threads == 1 || sizeof(K) == 1 || size < (1 << 16)) {
+			if (auto result = radix::lsd(data, scratch.get(), size, key, sizeof(K)); result != data)
+				std::move(result, result + size, data);
+			return;
+		}
+
+		unsigned shift = (sizeof(K) - 1) * 8;
+		auto counts = std::vector<radix::histogram>(threads);
+
+		parallel_chunks(0, size, [&](size_t begin, size_t end, size_t thread) {
+			for (size_t i = begin; i < end; i++)
+				counts[thread][(radix::to_unsigned(std::invoke(key, data[i])) >> shift) & 0xFF]++;
+		}, threads);
+
+		// Bucket-major prefix sum, so each thread scatters into its own slice of every bucket
+		auto bucket_begin = std::array<std::size_t, 257>();
+		for (std::size_t digit = 0, offset = 0; digit < 256; digit++) {
+			bucket_begin[digit] = offset;
+			for (auto& count : counts)
+				offset += std::exchange(count[digit], offset);
+		}
+		bucket_begin[256] = size;
+
+		parallel_chunks(0, size, [&](size_t begin, size_t end, size_t thread) {
+			radix::scatter(data + begin, scratch.get(), end - begin, counts[thread], shift, key);
+		}, threads);
+
+		std::atomic<std::size_t> next_bucket = 0;
+
+		parallel_chunks(0, threads, [&](size_t, size_t, size_t) {
+			for (std::size_t digit; (digit = next_bucket++) < 256; ) {
+
+				auto begin = bucket_begin[digit], count = bucket_begin[digit + 1] - begin;
+				if (count == 0) continue;
+
+				auto local_key = key;
+				auto result = count > 1 ? radix::lsd(scratch.get() + begin, data + begin, count, local_key, sizeof(K) - 1) : scratch.get() + begin;
+				if (result != data + begin) std::move(result, result + count, data + begin);
+			}
+		}, threads);
+	}
+}
@@ -3,17 +3,38 @@
 #include <cmath>
 #include <atomic>
 #include <ranges>
+#include <numeric>
+#include <chrono>
+#include <ctime>
+#include <limits>
 
 //import RozeFoundUtils;
 //import Experiments;
 
 #include "Utils.hpp"
+#include "Layout.hpp"
+#include "Primes.hpp"
+#include "Bitset.hpp"
+#include "Factor.hpp"
+#include "Wheel.hpp"
+#include "Trace.hpp"
+#include "Writer.hpp"
+#include "Async.hpp"
+#include "Pipeline.hpp"
+#include "Parallel.hpp"
+#include "Numa.hpp"
 #include "Experiments.hpp"
 
 #include <iostream>
 #include <functional>
+#include <stdexcept>
+#include <system_error>
 #include <algorithm>
 
+#include <fmt/core.h>
+
+#include <sys/resource.h>
+
 #ifdef THIRD_PARTY
 #include <xxh3.h>
 #endif
@@ -22,55 +43,115 @@
 #include "murmurhash2.hpp"
 
 namespace u = RozeFoundUtils;
+using u::primes::is_prime;
 
-constexpr bool is_prime (const std::integral auto n) {
+void MultiThreading() {
 
-	if (n == 2) return true;
-	else if (n <= 1 || ~n & 1)
-		return false;
+	constexpr size_t size = 10000000;
+	std::atomic<int> count = 0;
 
-	for (int i = 3; i < n / 2; i += 2)
-		if (n % i == 0) return false;
+	unsigned int thread_count = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::thread> threads;
 
-	return true;
-	
+	u::Timer timer;
+
+	// Trial division gets slower with i, the weighted split gives every thread the same total
+	u::partitioner parts(0, size, thread_count, [](size_t i) { return std::sqrt(double(i)); });
+
+	for (size_t i = 0; i < thread_count; i++)
+		threads.push_back(std::thread([&, i] {
+			parts.run(i, [&](size_t begin, size_t end) {
+				for (; begin < end; begin++)
+					if (is_prime((int)begin)) count++;
+			});
+		}));
+
+	for (auto& thread : threads)
+		thread.join();
+
+	u::print("Count:", count);
 }
 
-void MultiThreading() {
+// Every schedule has to visit every index exactly once, whatever the range, worker count or grain
 
-	constexpr size_t size = 10000000;
-	std::atomic<int> count = 0;
+void test_partition() {
 
-	auto func = [&](size_t min, size_t max) {
-		for (; min <= max; min++) {
-			if (is_prime((int)min)) {
-				count++;
-			}
-		}
+	std::mt19937 generator(42);
+	auto random = [&](size_t limit) { return std::uniform_int_distribution<size_t>(0, limit)(generator); };
+
+	auto schedules = { u::schedule::even, u::schedule::dynamic, u::schedule::guided, u::schedule::weighted };
+	size_t cases = 0;
+
+	// Skewed, partly free cost, like trial division past a cutoff
+	auto cost = [](size_t i) { return i % 7 == 0 ? 0.0 : double(i * i); };
+
+	auto make = [&](size_t begin, size_t end, size_t workers, u::schedule kind, size_t grain) {
+		if (kind == u::schedule::weighted) return u::partitioner(begin, end, workers, cost);
+		return u::partitioner(begin, end, workers, kind, grain);
 	};
 
-	unsigned int thread_count = std::thread::hardware_concurrency();
-	std::vector<std::thread> threads;
+	for (int round = 0; round < 300; round++) {
 
-	u::Timer timer;
+		size_t begin = random(1000), end = begin + random(round % 10 == 0 ? 3 : 5000);
+		size_t workers = 1 + random(round % 3 == 0 ? 2 : 70), grain = 1 + random(64);
+
+		for (auto kind : schedules) {
 
-	size_t base = size / thread_count;
-	size_t leftover = size % thread_count;
+			auto visits = std::vector<std::atomic<int>>(end);
 
-	for (size_t i = 0; i < thread_count; i++) {
+			auto parts = make(begin, end, workers, kind, grain);
+			u::parallel_chunks(parts, [&](size_t first, size_t last, size_t) {
+				if (first > last || last > end) throw std::runtime_error("chunk outside of the range");
+				for (size_t i = first; i < last; i++) visits[i]++;
+			});
 
-		size_t min = base * i;
-		size_t max = leftover + base * (i + 1);
-		if (i == thread_count) max += leftover;
+			for (size_t i = 0; i < end; i++)
+				if (visits[i] != (i >= begin ? 1 : 0))
+					throw std::runtime_error(fmt::format("index {} of [{}, {}) visited {} times", i, begin, end, visits[i].load()));
 
-		threads.push_back(std::thread(func, min, max));
+			cases++;
+		}
 	}
 
+	// Same with more threads than this machine has
+	for (auto kind : schedules) {
+		std::atomic<size_t> sum = 0;
+		auto parts = make(3, 100003, 8, kind, 100);
+		u::parallel_chunks(parts, [&](size_t first, size_t last, size_t) { for (; first < last; first++) sum += first; });
+		if (sum != (3 + 100002) * size_t(100000) / 2) throw std::runtime_error("threaded partition missed indices");
+		cases++;
+	}
 
-	for (auto& thread : threads)
-		thread.join();
+	// A weighted split asked for without a cost is an error, not an even split
+	try {
+		u::partitioner parts(0, 100, 4, u::schedule::weighted);
+		throw std::runtime_error("weighted schedule without a cost was accepted");
+	}
+	catch (const std::invalid_argument&) {}
+
+	// Balanced by cost, 1e6 indices over 4 workers with cost i: the last chunk is the shortest
+	u::partitioner balanced(0, 1000000, 4, [](size_t i) { return double(i); });
+	for (size_t worker = 0; worker < 4; worker++) {
+		auto part = *balanced.next(worker);
+		u::print("weighted chunk", worker, ":", part.begin, "-", part.end);
+	}
+
+	// The parallel prime count has to agree with the sequential one
+	constexpr int limit = 200000;
+	int sequential = 0;
+	for (int i = 0; i < limit; i++) if (is_prime(i)) sequential++;
+
+	for (auto kind : schedules) {
+		std::atomic<int> parallel = 0;
+		auto options = kind == u::schedule::weighted
+			? u::parallel_options { .cost = [](size_t i) { return std::sqrt(double(i)); } }
+			: u::parallel_options { .kind = kind };
+		u::parallel_for(0, limit, [&](int i) { if (is_prime(i)) parallel++; }, options);
+		if (parallel != sequential) throw std::runtime_error(fmt::format("parallel count {} != {}", parallel.load(), sequential));
+	}
+
+	u::print("partition:", cases, "cases ok, primes below", limit, "=", sequential);
 
-	u::print("Count:", count);
 }
 
 void ArrayTest() {
@@ -81,11 +162,10 @@ void ArrayTest() {
 	std::uniform_int_distribution distribution(1, (int)size);
 	auto rand = std::bind(distribution, generator);
 
-	auto arr = array(size);
+	auto arr = small_array<int, size>(size);
 	for (int& n : arr) n = rand();
 
-	// std::ranges::sort(arr);
-	std::sort(arr.begin(), arr.end());
+	std::ranges::sort(arr);
 
 	u::print("Array:", arr | ext::join);
 }
@@ -138,17 +218,426 @@ class A {
 
 };
 
+using A_layout = u::layout<
+	u::field<"secret", int, 0>,
+	u::field<"hello", std::array<char, 16>, 4>,
+	u::field<"second_secret", int, 20>
+>;
+
 void test_access_private_members() {
 
 	A a;
 
 	auto signature = u::to_bytes("55 48 89 E5 48 83 EC 10 40 88 f0 48 89 7D F8 24 01");
 	auto func_address = u::basic_sigscan(u::get_module_base(), signature);
-	auto private_func = (void(__cdecl*)(void* _this))func_address;
+	auto private_func = (void(*)(void* _this))func_address;
+
+	auto snapshot = A_layout::read(a);
 
-	u::print("secret is:", u::get_at_offset<int>(a, 0));
-	u::print("second secret is:", u::get_at_offset<int>(a, 20));
-	u::print(u::get_at_offset<char*>(a, 4));
+	u::print("secret is:", snapshot.get<"secret">());
+	u::print("second secret is:", snapshot.get<"second_secret">());
+	u::print(snapshot.get<"hello">().data());
+
+	if (auto remote = A_layout::read(0, reinterpret_cast<std::ptrdiff_t>(&a)))
+		u::print("remote secret is:", remote->get<"secret">());
 	private_func(&a);
 
 }
+
+void test_prime_pi() {
+
+	for (size_t x : { 10, 1000, 65535, 65536, 1000000, 10000019, 123456789 }) {
+		auto sieved = u::primes::count_primes(x + 1);
+		auto counted = u::primes::prime_pi(x);
+		u::print("pi(", x, ") =", counted, sieved == counted ? "(matches sieve)" : "(MISMATCH)");
+	}
+
+	u::makeTimer("pi(1e15)", [&]{
+		auto counted = u::primes::prime_pi(1000000000000000);
+		u::print(counted, counted == 29844570422669 ? "(matches)" : "(MISMATCH)");
+	});
+
+}
+
+void test_prime_bitmap() {
+
+	auto path = std::filesystem::temp_directory_path() / "primes.bin";
+
+	u::makeTimer("write bitmap", [&]{ u::primes::write_bitmap(path, 100000000); });
+
+	u::primes::bitmap primes(path);
+
+	u::print("primes below", primes.limit(), ":", primes.count());
+	u::print("is_prime(99999989):", primes.is_prime(99999989));
+	u::print("pi(1000000):", primes.pi(1000000));
+	u::print("nth_prime(1000000):", primes.nth_prime(1000000));
+
+}
+
+void test_factorize() {
+
+	for (uint64_t n : { 360ull, 600851475143ull, 18446744073709551615ull, 18446743979220271189ull })
+		u::print(n, "=", u::primes::factorize(n) | ext::join_with(" * ", "", ""));
+
+	auto values = std::vector<uint64_t>(100000);
+	std::mt19937_64 engine(42);
+	for (auto& value : values) value = engine();
+
+	u::makeTimer("factorize 100000 random u64", [&]{ u::primes::factorize(values); });
+
+	u::primes::spf_sieve sieve(10000000);
+	u::print("spf(9999991) =", sieve.smallest_factor(9999991), "primes below 1e7:", sieve.primes().size());
+
+}
+
+void test_tracing() {
+
+	auto path = std::filesystem::temp_directory_path() / "trace.json";
+	u::trace::start(path);
+
+	auto blocks = Range<int>(64);
+	u::parallel_for(blocks, [&](int block) {
+		SCOPED_ZONE("sieve block");
+		u::primes::count_primes(1 << 20);
+	});
+
+	auto data = std::string(1 << 20, 'x');
+	for (int i = 0; i < 16; i++) {
+		SCOPED_ZONE("sha1 1MiB");
+		SHA1 checksum;
+		checksum.update(data);
+		auto hash = checksum.final();
+	}
+
+	u::trace::stop();
+	u::print("trace written to", path, "dropped events:", u::trace::dropped());
+
+}
+
+void test_counters() {
+
+	constexpr size_t limit = 100000000;
+	u::makeProfile("sieve 1e8", [&]{ u::primes::count_primes(limit); }, limit);
+
+	auto data = std::string(16 << 20, 'x');
+	u::makeProfile("sha1 16MiB", [&]{
+		SHA1 checksum;
+		checksum.update(data);
+		auto hash = checksum.final();
+	}, data.size());
+
+}
+
+void test_async_writer() {
+
+	auto directory = std::filesystem::temp_directory_path() / "results";
+	std::filesystem::create_directories(directory);
+
+	constexpr int count = 1000;
+
+	u::makeTimer("write_to_file x1000", [&]{
+		for (int i = 0; i < count; i++)
+			u::write_to_file(std::to_string(i), directory / (std::to_string(i) + ".txt"));
+	});
+
+	// The caller only pays for queueing, the writes complete in the background
+	auto done = std::vector<std::future<void>>();
+	u::makeTimer("io::write_to_file x1000 (queue)", [&]{
+		for (int i = 0; i < count; i++)
+			done.push_back(u::io::write_to_file(std::to_string(i), directory / (std::to_string(i) + ".txt"), { .atomic = true }));
+	});
+	u::makeTimer("io::write_to_file x1000 (complete)", [&]{
+		for (auto& future : done) future.get();
+	});
+
+	auto log = directory / "log.txt";
+	for (int i = 0; i < count; i++) u::io::write_to_file(std::to_string(i) + '\n', log, { .append = i > 0 });
+	u::io::write_to_file("", log, { .append = true, .sync = true }).get();
+
+	u::print("log lines:", std::ranges::count(*u::read_from_file(log), '\n'));
+
+	// Far more files than descriptors, the writer opens them a window at a time
+	rlimit limit;
+	getrlimit(RLIMIT_NOFILE, &limit);
+	auto lowered = limit;
+	lowered.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 128);
+	setrlimit(RLIMIT_NOFILE, &lowered);
+
+	u::io::async_writer writer;
+	done.clear();
+	for (int i = 0; i < count; i++)
+		done.push_back(writer.write(directory / (std::to_string(i) + ".txt"), std::to_string(i), { .atomic = true }));
+
+	int failed = 0;
+	for (auto& future : done) {
+		try { future.get(); }
+		catch (const std::system_error&) { failed++; }
+	}
+
+	setrlimit(RLIMIT_NOFILE, &limit);
+	u::print("writes failed with 128 descriptors:", failed);
+
+}
+
+u::io::task<std::string> read_and_hash(u::io::event_loop& loop, std::filesystem::path path) {
+	SHA1 checksum;
+	checksum.update(co_await u::io::read(loop, std::move(path)));
+	co_return checksum.final();
+}
+
+void test_async_io() {
+
+	u::io::event_loop loop;
+	u::print("io_uring:", loop.uses_uring());
+
+	auto files = std::vector<std::filesystem::path>();
+	for (const auto& entry : std::filesystem::directory_iterator("/usr/include"))
+		if (entry.is_regular_file()) files.push_back(entry.path());
+
+	u::makeTimer("read and hash headers", [&]{
+		auto hashes = loop.run([&]() -> u::io::task<std::vector<std::string>> {
+			auto reads = std::vector<u::io::task<std::string>>();
+			for (const auto& file : files) reads.push_back(read_and_hash(loop, file));
+			co_return co_await u::io::when_all(std::move(reads));
+		}());
+		u::print("hashed", hashes.size(), "files");
+	});
+
+	auto pid = loop.run(u::io::get_process_id(loop, "cpptests"));
+	u::print("pid:", pid, "module base:", loop.run(u::io::get_module_base(loop)));
+
+}
+
+void test_pipeline() {
+
+	using file = std::pair<std::filesystem::path, std::string>;
+
+	auto paths = std::vector<std::filesystem::path>();
+	for (const auto& entry : std::filesystem::recursive_directory_iterator("/usr/include"))
+		if (entry.is_regular_file()) paths.push_back(entry.path());
+
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// read -> hash -> hex, every stage overlapping the others
+	u::makeTimer("fingerprint pipeline", [&]{
+
+		auto fingerprints = u::make_pipeline(paths)
+			.then([](const std::filesystem::path& path) -> std::optional<file> {
+				try { return file { path, *u::read_from_file(path) }; }
+				catch (const std::exception&) { return std::nullopt; }
+			}, 2)
+			.then([](file f) {
+				uint32_t hash = MurmurHash2(f.second.data(), int(f.second.size()), 1);
+				return file { std::move(f.first), std::string(reinterpret_cast<const char*>(&hash), sizeof(hash)) };
+			}, threads)
+			.then([](file f) {
+				auto hex = std::string(f.second.size() * 2 + 1, '\0');
+				u::hex::hex_to(hex.begin(), f.second);
+				hex.pop_back();
+				return f.first.filename().string() + ' ' + hex;
+			})
+			.collect();
+
+		u::print("fingerprinted", fingerprints.size(), "of", paths.size(), "files");
+		if (!fingerprints.empty()) u::print("e.g.", fingerprints.front());
+	});
+
+	// A slow stage leaves everything after it blocked instead of spinning on an empty queue
+	auto cpu = std::clock();
+	auto wall = std::chrono::steady_clock::now();
+
+	auto doubled = u::make_pipeline(Range<int>(5))
+		.then([](int i) { std::this_thread::sleep_for(std::chrono::milliseconds(100)); return i; })
+		.then([](int i) { return i * 2; }, threads)
+		.collect();
+
+	double busy = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall).count();
+	u::print("slow stage:", doubled.size(), "items in", elapsed, "s using", busy, "s of cpu");
+
+}
+
+void test_numa() {
+
+	const auto& topology = u::numa::topology::system();
+
+	for (const auto& node : topology.nodes())
+		u::print("node", node.id, "cpus:", node.cpus.size());
+
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t i = 0; i < threads; i++)
+		u::print("worker", i, "-> cpu", topology.cpu_for(i, threads), "node", topology.node_of(topology.cpu_for(i, threads)));
+
+	constexpr size_t size = 1 << 26;
+
+	auto sum = [](std::span<const uint64_t> values) {
+		std::atomic<uint64_t> total = 0;
+		u::parallel_chunks(0, values.size(), [&](size_t begin, size_t end, size_t) {
+			total += std::accumulate(values.begin() + begin, values.begin() + end, uint64_t(0));
+		});
+		return total.load();
+	};
+
+	// Zeroed by the calling thread, every page on its node
+	auto serial = std::vector<uint64_t>(size, 1);
+	u::makeTimer("sum, touched by one thread", [&]{ u::print(sum(serial)); });
+
+	// Touched by the same workers that sum it
+	auto local = u::parallel::make_first_touch<uint64_t>(size, 1);
+	u::makeTimer("sum, first touched in parallel", [&]{ u::print(sum(std::span(local.get(), size))); });
+
+}
+
+// Trial division up to 4e6 on 4 threads: an even split leaves the first threads idle
+// while the last one works through the expensive end, the cost-aware ones don't
+
+void test_scheduling() {
+
+	constexpr size_t size = 4000000;
+	auto numbers = Range<int>(size);
+
+	auto run = [&](std::string_view name, u::parallel_options options) {
+
+		std::atomic<int> count = 0;
+		u::run_stats stats;
+
+		options.threads = 4;
+		options.stats = &stats;
+
+		u::parallel_for(numbers, [&](int i) { if (is_prime(i)) count++; }, options);
+
+		u::print(name, "count:", count);
+		stats.print(name);
+	};
+
+	run("even", {});
+	run("dynamic", { .kind = u::schedule::dynamic });
+	run("guided", { .kind = u::schedule::guided });
+	run("growing", { .growing = true });
+	run("weighted sqrt(i)", { .cost = [](size_t i) { return std::sqrt(double(i)); } });
+
+}
+
+void test_wheel() {
+
+	constexpr uint64_t from = 1000000000, to = from + 10000000;
+
+	auto candidates = u::primes::wheel_candidates(from, to);
+	auto batch = std::vector<uint64_t>(4096);
+
+	size_t generated = 0, survived = 0;
+	while (size_t count = candidates.next_batch(batch)) {
+		generated += count;
+		survived += u::primes::filter_small_factors(std::span(batch.data(), count));
+	}
+
+	u::print("of", to - from, "numbers", generated, "are wheel candidates,", survived, "survive the filter");
+
+	size_t found = 0;
+	u::makeTimer("primes_between", [&]{ found = u::primes::primes_between(from, to).size(); });
+
+	size_t checked = 0;
+	u::makeTimer("is_prime_u64 on every odd number", [&]{
+		for (uint64_t n = from | 1; n < to; n += 2) checked += u::primes::is_prime_u64(n);
+	});
+
+	u::print("primes:", found, checked, "pi difference:", u::primes::prime_pi(to - 1) - u::primes::prime_pi(from - 1));
+
+}
+
+void test_bitset() {
+
+	std::mt19937_64 generator(7);
+
+	for (size_t size : { 0, 1, 63, 64, 65, 1000, 4099 }) {
+
+		auto bits = u::bitset(size);
+		auto reference = std::vector<bool>(size);
+
+		for (size_t i = 0; i < size; i++)
+			if (generator() % 3 == 0) { bits.set(i); reference[i] = true; }
+
+		if (size > 10) {
+			bits.reset_stride(3, 7);
+			for (size_t i = 3; i < size; i += 7) reference[i] = false;
+			bits.set_stride(5, 11);
+			for (size_t i = 5; i < size; i += 11) reference[i] = true;
+		}
+
+		size_t count = std::ranges::count(reference, true);
+		if (bits.count() != count) throw std::runtime_error("bitset count is off");
+
+		for (size_t i = 0, rank = 0; i <= size; i++) {
+			if (bits.rank(i) != rank) throw std::runtime_error(fmt::format("rank({}) of {} bits is off", i, size));
+			if (i < size && reference[i]) {
+				if (bits.select(rank) != i) throw std::runtime_error(fmt::format("select({}) of {} bits is off", rank, size));
+				rank++;
+			}
+		}
+
+		if (bits.select(count) != size) throw std::runtime_error("select past the last bit should give size");
+	}
+
+	auto sieve = u::bitset(100000000, true);
+	u::makeTimer("popcount of 1e8 bits", [&]{ u::print(sieve.count()); });
+
+	u::print("bitset ok, primes below 1e8:", u::primes::count_primes(100000000));
+
+}
+
+void test_prime_generator() {
+
+	// As a range, every prime below 1e6 in order
+	uint64_t sum = 0, count = 0;
+	for (uint64_t p : u::primes::prime_generator(0, 1000000)) {
+		sum += p;
+		count++;
+	}
+
+	u::print("primes below 1e6:", count, "sum:", sum, "sieve says:", u::primes::count_primes(1000000));
+
+	// In batches, a window far out without ever holding more than one sieve window
+	constexpr uint64_t from = 1000000000000, to = from + 100000000;
+
+	auto generator = u::primes::prime_generator(from, to);
+	auto batch = std::vector<uint64_t>(1 << 12);
+
+	uint64_t found = 0, largest = 0;
+	u::makeTimer("primes in [1e12, 1e12 + 1e8)", [&]{
+		while (size_t n = generator.next_batch(batch)) {
+			found += n;
+			largest = batch[n - 1];
+		}
+	});
+
+	u::print("found:", found, "largest:", largest, "pi difference:", u::primes::prime_pi(to - 1) - u::primes::prime_pi(from - 1));
+
+}
+
+void test_range() {
+
+	// Steps past the last element used to land outside T, end() has to stay exact
+	auto bytes = Range<uint8_t>(0, 255, 2);
+	size_t visited = 0;
+	for (uint8_t value : bytes)
+		if (value != 2 * visited++) throw std::runtime_error("Range<uint8_t> value is off");
+	if (visited != 128 || bytes.size() != 128 || bytes.end() - bytes.begin() != 128 || bytes.back() != 254)
+		throw std::runtime_error("Range<uint8_t>(0, 255, 2) should have 128 elements ending in 254");
+
+	constexpr int max = std::numeric_limits<int>::max(), min = std::numeric_limits<int>::min();
+
+	auto up = Range<int>(0, max, 2);
+	auto tail = up.slice(up.size() - 3, up.size());
+	if (up.back() != max - 1 || !std::ranges::equal(tail, std::vector { max - 5, max - 3, max - 1 }))
+		throw std::runtime_error("Range<int>(0, INT_MAX, 2) should end in INT_MAX - 1");
+
+	auto down = Range<int>(max, min, -3);
+	auto pieces = down.split(7);
+	size_t total = 0;
+	for (const auto& piece : pieces) total += size_t(piece.end() - piece.begin());
+	if (total != down.size() || pieces.back().back() != down.back() || down.back() != min + 3)
+		throw std::runtime_error("Range<int>(INT_MAX, INT_MIN, -3) pieces don't add up");
+
+	u::print("range ok,", down.size(), "elements from INT_MAX down to", down.back());
+
+}
@@ -0,0 +1,212 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <unistd.h>
+
+namespace RozeFoundUtils::trace {
+
+    namespace {
+
+        struct registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ring>> rings;
+            uint32_t next_id = 0;
+        };
+
+        registry& rings() {
+            static registry instance;
+            return instance;
+        }
+
+        // Marks the ring closed when its thread exits
+        struct owner {
+            std::shared_ptr<trace::ring> held;
+            ~owner() { if (held) held->closed = true; }
+        };
+
+        thread_local owner local_owner;
+
+        void escape_to(fmt::memory_buffer& out, const char* name) {
+            for (; *name; name++) {
+                if (*name == '"' || *name == '\\') out.push_back('\\');
+                if (static_cast<unsigned char>(*name) < 0x20) fmt::format_to(std::back_inserter(out), "\\u{:04x}", int(*name));
+                else out.push_back(*name);
+            }
+        }
+
+        class session {
+
+        public:
+
+            session(const std::filesystem::path& path, std::chrono::milliseconds interval) {
+
+                m_File = std::fopen(path.c_str(), "wb");
+                if (!m_File) throw std::runtime_error("Can't open trace file for writing");
+
+                std::fputs("{\"traceEvents\":[", m_File);
+
+                // Leftovers from an earlier session or zones still open when it stopped
+                drain([](const event&, uint32_t) {});
+
+                m_OriginTicks = ticks();
+                m_OriginTime = std::chrono::steady_clock::now();
+                m_Pid = getpid();
+
+                detail::enabled.store(true, std::memory_order_relaxed);
+
+                m_Flusher = std::jthread([this, interval](std::stop_token token) {
+
+                    std::mutex mutex;
+                    std::condition_variable_any wakeup;
+
+                    while (!token.stop_requested()) {
+                        std::unique_lock lock(mutex);
+                        wakeup.wait_for(lock, token, interval, [] { return false; });
+                        flush();
+                    }
+                });
+            }
+
+            ~session() { if (m_File) close(); }
+
+            void close() {
+
+                detail::enabled.store(false, std::memory_order_relaxed);
+
+                m_Flusher.request_stop();
+                m_Flusher.join();
+
+                flush();
+
+                std::fputs("\n]}\n", m_File);
+                std::fclose(m_File);
+                m_File = nullptr;
+            }
+
+            std::size_t dropped() const noexcept { return m_Dropped.load(std::memory_order_relaxed); }
+
+        private:
+
+            // Local methods
+
+            template<typename F> void drain(F&& sink) {
+
+                std::vector<std::shared_ptr<ring>> snapshot;
+                {
+                    std::lock_guard lock(rings().mutex);
+                    snapshot = rings().rings;
+                }
+
+                std::vector<ring*> finished;
+
+                for (auto& ring : snapshot) {
+                    bool closed = ring->closed;
+                    ring->drain([&](const event& e) { sink(e, ring->thread_id()); });
+                    m_Dropped.fetch_add(ring->take_dropped(), std::memory_order_relaxed);
+                    if (closed) finished.push_back(ring.get());
+                }
+
+                if (finished.empty()) return;
+
+                std::lock_guard lock(rings().mutex);
+                std::erase_if(rings().rings, [&](const auto& ring) {
+                    return std::find(finished.begin(), finished.end(), ring.get()) != finished.end();
+                });
+            }
+
+            void flush() {
+
+                // The TSC rate is measured against the steady clock over the whole session so far
+                auto elapsed = std::chrono::steady_clock::now() - m_OriginTime;
+                while (elapsed < std::chrono::milliseconds(1))
+                    elapsed = std::chrono::steady_clock::now() - m_OriginTime;
+
+                double ticks_per_us = double(ticks() - m_OriginTicks) / std::chrono::duration<double, std::micro>(elapsed).count();
+
+                fmt::memory_buffer out;
+
+                drain([&](const event& e, uint32_t thread_id) {
+
+                    out.append(std::string_view(m_Written++ ? ",\n{\"name\":\"" : "\n{\"name\":\""));
+                    escape_to(out, e.name);
+
+                    fmt::format_to(std::back_inserter(out), "\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}",
+                        (double(e.start) - double(m_OriginTicks)) / ticks_per_us, double(e.end - e.start) / ticks_per_us, m_Pid, thread_id);
+                });
+
+                std::fwrite(out.data(), 1, out.size(), m_File);
+                std::fflush(m_File);
+            }
+
+            // Local variables
+
+            std::FILE* m_File = nullptr;
+
+            uint64_t m_OriginTicks = 0;
+            std::chrono::steady_clock::time_point m_OriginTime;
+            int m_Pid = 0;
+
+            std::size_t m_Written = 0;
+            std::atomic<std::size_t> m_Dropped = 0;
+
+            std::jthread m_Flusher;
+        };
+
+        std::mutex session_mutex;
+        std::unique_ptr<session> current;
+        std::size_t last_dropped = 0;
+    }
+
+    namespace detail {
+
+        ring* register_thread() {
+
+            std::lock_guard lock(rings().mutex);
+
+            local_owner.held = std::make_shared<ring>(rings().next_id++);
+            rings().rings.push_back(local_owner.held);
+
+            return local = local_owner.held.get();
+
+        }
+    }
+
+    void start(const std::filesystem::path& path, std::chrono::milliseconds interval) {
+
+        std::lock_guard lock(session_mutex);
+        if (current) throw std::runtime_error("Trace session is already running");
+
+        current = std::make_unique<session>(path, interval);
+
+    }
+
+    void stop() {
+
+        std::lock_guard lock(session_mutex);
+        if (!current) return;
+
+        current->close();
+        last_dropped = current->dropped();
+        current.reset();
+
+    }
+
+    bool running() noexcept {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    std::size_t dropped() {
+
+        std::lock_guard lock(session_mutex);
+        return current ? current->dropped() : last_dropped;
+
+    }
+}
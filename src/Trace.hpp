@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// SCOPED_ZONE("name") records the time spent in the enclosing scope while a
+// trace session is running. Names must outlive the session, string literals do.
+// Define NO_TRACING to compile every zone out
+
+#define ROZE_CONCAT_IMPL(a, b) a##b
+#define ROZE_CONCAT(a, b) ROZE_CONCAT_IMPL(a, b)
+
+#ifdef NO_TRACING
+#define SCOPED_ZONE(name) ((void)0)
+#else
+#define SCOPED_ZONE(name) ::RozeFoundUtils::trace::zone ROZE_CONCAT(zone_, __LINE__)(name)
+#endif
+
+namespace RozeFoundUtils {
+
+	namespace trace {
+
+		struct event {
+			const char* name;
+			uint64_t start, end;
+		};
+
+		// Raw timestamp, the TSC where there is one and steady clock nanoseconds elsewhere
+		inline uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+		}
+
+		// Single producer, single consumer ring of events. The owning thread
+		// pushes, the flusher drains, events that don't fit are counted and dropped
+
+		class ring {
+
+		public:
+
+			static constexpr std::size_t capacity = 1 << 14;
+
+			// Constructors
+
+			explicit ring(uint32_t thread_id) noexcept : m_ThreadId(thread_id) {}
+
+			// Methods
+
+			bool push(const event& e) noexcept {
+
+				auto head = m_Head.load(std::memory_order_relaxed);
+
+				if (head - m_Tail.load(std::memory_order_acquire) == capacity) {
+					m_Dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+
+				m_Events[head % capacity] = e;
+				m_Head.store(head + 1, std::memory_order_release);
+
+				return true;
+			}
+
+			// Hands every pending event to sink, returns how many there were
+			template<typename F> std::size_t drain(F&& sink) {
+
+				auto tail = m_Tail.load(std::memory_order_relaxed);
+				auto head = m_Head.load(std::memory_order_acquire);
+
+				for (auto i = tail; i != head; i++) sink(m_Events[i % capacity]);
+				m_Tail.store(head, std::memory_order_release);
+
+				return head - tail;
+			}
+
+			uint32_t thread_id() const noexcept { return m_ThreadId; }
+			std::size_t take_dropped() noexcept { return m_Dropped.exchange(0, std::memory_order_relaxed); }
+
+			// Set once the owning thread exits, the ring is released after its last drain
+			std::atomic<bool> closed = false;
+
+		private:
+
+			// Local variables
+
+			alignas(64) std::atomic<std::size_t> m_Head = 0;
+			alignas(64) std::atomic<std::size_t> m_Tail = 0;
+			alignas(64) std::atomic<std::size_t> m_Dropped = 0;
+
+			uint32_t m_ThreadId;
+			event m_Events[capacity];
+		};
+
+		namespace detail {
+
+			inline std::atomic<bool> enabled = false;
+
+			inline thread_local ring* local = nullptr;
+
+			// Creates the calling thread's ring and hands it to the flusher
+			ring* register_thread();
+		}
+
+		class zone {
+
+		public:
+
+			// Constructors
+
+			explicit zone(const char* name) noexcept
+				: m_Name(name), m_Start(detail::enabled.load(std::memory_order_relaxed) ? ticks() : 0) {}
+
+			~zone() {
+
+				if (m_Start == 0) return;
+
+				auto end = ticks();
+				auto* ring = detail::local ? detail::local : detail::register_thread();
+				ring->push({ m_Name, m_Start, end });
+			}
+
+			zone(const zone&) = delete;
+			zone& operator=(const zone&) = delete;
+
+		private:
+
+			// Local variables
+
+			const char* m_Name;
+			uint64_t m_Start;
+		};
+
+		// Starts recording and a background thread draining every ring into path
+		// as Chrome trace event JSON, loadable by chrome://tracing and Perfetto
+		void start(const std::filesystem::path& path, std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+		// Stops recording, drains whatever is left and closes the file
+		void stop();
+
+		bool running() noexcept;
+
+		// Events lost to full rings in the running session, or the last one once stopped
+		std::size_t dropped();
+	}
+}
@@ -0,0 +1,144 @@
+#include "Uring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RozeFoundUtils::io {
+
+    namespace {
+
+        int setup(unsigned entries, io_uring_params& params) {
+            return int(syscall(__NR_io_uring_setup, entries, &params));
+        }
+
+        int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+            return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        template<typename T> T* at(void* base, uint32_t offset) {
+            return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+        }
+    }
+
+    uring::uring(unsigned entries) {
+
+        io_uring_params params = {};
+
+        m_Fd = setup(entries, params);
+        if (m_Fd < 0) throw std::system_error(errno, std::system_category(), "io_uring_setup");
+
+        m_Entries = params.sq_entries;
+
+        m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        // Newer kernels map both rings with one call
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+
+        auto map = [&](std::size_t size, off_t offset) {
+            void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, offset);
+            if (mapping == MAP_FAILED) {
+                int error = errno;
+                release();
+                throw std::system_error(error, std::system_category(), "io_uring mmap");
+            }
+            return mapping;
+        };
+
+        m_SqRing = map(m_SqRingSize, IORING_OFF_SQ_RING);
+        m_CqRing = single ? m_SqRing : map(m_CqRingSize, IORING_OFF_CQ_RING);
+
+        m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_Sqes = static_cast<io_uring_sqe*>(map(m_SqesSize, IORING_OFF_SQES));
+
+        m_SqHead = at<unsigned>(m_SqRing, params.sq_off.head);
+        m_SqTail = at<unsigned>(m_SqRing, params.sq_off.tail);
+        m_SqMask = at<unsigned>(m_SqRing, params.sq_off.ring_mask);
+        m_SqArray = at<unsigned>(m_SqRing, params.sq_off.array);
+
+        m_CqHead = at<unsigned>(m_CqRing, params.cq_off.head);
+        m_CqTail = at<unsigned>(m_CqRing, params.cq_off.tail);
+        m_CqMask = at<unsigned>(m_CqRing, params.cq_off.ring_mask);
+        m_Cqes = at<io_uring_cqe>(m_CqRing, params.cq_off.cqes);
+
+        m_Prepared = m_Submitted = *m_SqTail;
+
+    }
+
+    uring::~uring() {
+        release();
+    }
+
+    void uring::release() noexcept {
+
+        if (m_Sqes) munmap(m_Sqes, m_SqesSize);
+        if (m_CqRing && m_CqRing != m_SqRing) munmap(m_CqRing, m_CqRingSize);
+        if (m_SqRing) munmap(m_SqRing, m_SqRingSize);
+        if (m_Fd >= 0) close(m_Fd);
+
+        m_Sqes = nullptr; m_CqRing = m_SqRing = nullptr; m_Fd = -1;
+
+    }
+
+    bool uring::supported() noexcept {
+
+        static const bool result = [] {
+            io_uring_params params = {};
+            int fd = setup(2, params);
+            if (fd < 0) return false;
+            close(fd);
+            return true;
+        }();
+
+        return result;
+
+    }
+
+    io_uring_sqe* uring::get_sqe() noexcept {
+
+        unsigned head = std::atomic_ref(*m_SqHead).load(std::memory_order_acquire);
+        if (m_Prepared - head >= m_Entries) return nullptr;
+
+        unsigned index = m_Prepared & *m_SqMask;
+        m_SqArray[index] = index;
+        m_Prepared++;
+
+        auto* sqe = m_Sqes + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+
+        return sqe;
+
+    }
+
+    int uring::submit(unsigned wait_for) noexcept {
+
+        unsigned to_submit = m_Prepared - m_Submitted;
+        std::atomic_ref(*m_SqTail).store(m_Prepared, std::memory_order_release);
+
+        int result;
+        do result = enter(m_Fd, to_submit, wait_for, wait_for ? IORING_ENTER_GETEVENTS : 0);
+        while (result < 0 && errno == EINTR);
+
+        if (result < 0) return -errno;
+
+        m_Submitted += unsigned(result);
+        m_InFlight += unsigned(result);
+
+        return result;
+
+    }
+
+    void uring::discard() noexcept {
+
+        m_Prepared = m_Submitted;
+        std::atomic_ref(*m_SqTail).store(m_Submitted, std::memory_order_release);
+
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace RozeFoundUtils {
+
+	namespace io {
+
+		// Minimal io_uring over the raw syscalls, no liburing needed. Only one thread
+		// may prepare and submit, completions are reaped by the same thread
+
+		class uring {
+
+		public:
+
+			// Constructors
+
+			explicit uring(unsigned entries = 256);
+			uring(const uring&) = delete;
+			uring& operator=(const uring&) = delete;
+			~uring();
+
+			// Methods
+
+			// Whether the kernel lets this process create a ring at all
+			static bool supported() noexcept;
+
+			// Next free submission entry zeroed, nullptr while the queue is full
+			io_uring_sqe* get_sqe() noexcept;
+
+			// Hands prepared entries to the kernel and blocks until wait_for completions are
+			// ready, returns the number submitted or -errno
+			int submit(unsigned wait_for = 0) noexcept;
+
+			// Takes back the entries prepared since the last successful submit, for when
+			// the kernel keeps refusing them and what they point to is about to go away
+			void discard() noexcept;
+
+			// Calls f(user_data, result) for every ready completion, returns how many there were
+			template<typename F> unsigned reap(F&& f) {
+
+				unsigned head = *m_CqHead, count = 0;
+				unsigned tail = std::atomic_ref(*m_CqTail).load(std::memory_order_acquire);
+
+				for (; head != tail; head++, count++) {
+					const auto& cqe = m_Cqes[head & *m_CqMask];
+					f(cqe.user_data, cqe.res);
+				}
+
+				std::atomic_ref(*m_CqHead).store(head, std::memory_order_release);
+				m_InFlight -= count;
+
+				return count;
+			}
+
+			unsigned capacity() const noexcept { return m_Entries; }
+
+			// Submitted but not yet reaped
+			unsigned in_flight() const noexcept { return m_InFlight; }
+
+		private:
+
+			void release() noexcept;
+
+			// Local variables
+
+			int m_Fd = -1;
+			unsigned m_Entries = 0;
+
+			void* m_SqRing = nullptr; std::size_t m_SqRingSize = 0;
+			void* m_CqRing = nullptr; std::size_t m_CqRingSize = 0;
+			io_uring_sqe* m_Sqes = nullptr; std::size_t m_SqesSize = 0;
+
+			unsigned* m_SqHead = nullptr; unsigned* m_SqTail = nullptr;
+			unsigned* m_SqMask = nullptr; unsigned* m_SqArray = nullptr;
+
+			unsigned* m_CqHead = nullptr; unsigned* m_CqTail = nullptr;
+			unsigned* m_CqMask = nullptr; io_uring_cqe* m_Cqes = nullptr;
+
+			// Tail as far as entries were prepared, and as far as the kernel was told
+			unsigned m_Prepared = 0, m_Submitted = 0;
+			unsigned m_InFlight = 0;
+		};
+	}
+}
@@ -1,10 +1,16 @@
 #include "Utils.hpp"
+#include "Perf.hpp"
 
 #include <filesystem>
 #include <fstream>
+#include <sstream>
 #include <thread>
 #include <vector>
 
+#include <sys/uio.h>
+#include <unistd.h>
+#include <climits>
+
 namespace RozeFoundUtils {
 
     uint32_t get_process_id (std::string_view process_name) {
@@ -39,17 +45,58 @@ namespace RozeFoundUtils {
 
         auto maps = read_from_file(maps_path);
 
+        return find_module_base(*maps, module);
+
+    }
+
+    std::ptrdiff_t find_module_base (std::string_view maps, std::string_view module) {
+
         std::size_t start;
 
-        if (module.empty()) start = maps->find("r-xp");
-        else start = maps->find(module);
+        if (module.empty()) start = maps.find("r-xp");
+        else start = maps.find(module);
 
         std::size_t end = start;
 
-        while (maps->at(start) != '\n') start--;
-        while (maps->at(end) != '-') end--;
+        while (maps.at(start) != '\n') start--;
+        while (maps.at(end) != '-') end--;
+
+        return std::stol(std::string(maps.substr(start, end - start)), 0, 16);
+
+    }
+
+    bool read_process_memory (uint32_t process_id, std::ptrdiff_t address, std::byte* buffer, std::size_t size) {
+
+        std::ptrdiff_t addresses[] = { address };
+        std::byte* buffers[] = { buffer };
+
+        return read_process_memory(process_id, addresses, buffers, size);
+
+    }
+
+    bool read_process_memory (uint32_t process_id, std::span<const std::ptrdiff_t> addresses, std::span<std::byte* const> buffers, std::size_t size) {
+
+        pid_t pid = process_id == 0 ? getpid() : pid_t(process_id);
+
+        auto local = std::vector<iovec>(std::min<std::size_t>(addresses.size(), IOV_MAX));
+        auto remote = std::vector<iovec>(local.size());
 
-        return std::stol(maps->substr(start, end - start), 0, 16);
+        for (std::size_t done = 0; done < addresses.size(); ) {
+
+            std::size_t count = std::min(local.size(), addresses.size() - done);
+
+            for (std::size_t i = 0; i < count; i++) {
+                local[i] = { buffers[done + i], size };
+                remote[i] = { reinterpret_cast<void*>(addresses[done + i]), size };
+            }
+
+            auto read = process_vm_readv(pid, local.data(), count, remote.data(), count, 0);
+            if (read != ssize_t(count * size)) return false;
+
+            done += count;
+        }
+
+        return true;
 
     }
 
@@ -58,6 +105,11 @@ namespace RozeFoundUtils {
         func();
     }
 
+    void makeProfile(std::string_view name, std::function<void()> func, std::size_t elements) {
+        perf::scope scope(name, elements);
+        func();
+    }
+
     void write_to_file(std::string_view string, std::filesystem::path filepath) {
 
       std::ofstream file;
@@ -84,31 +136,21 @@ namespace RozeFoundUtils {
         }
     }
 
-    void parallel_for(size_t start, size_t end, std::function<void(int)> function) {
-
-        size_t thread_count = std::min((size_t)std::thread::hardware_concurrency(), end);
-        std::vector<std::thread> threads;
-
-        auto func = [&](size_t min, size_t max) {
-            for (size_t i = min; i <= max; i++)
-                function((int)i);
-        };
+    void parallel_for(size_t start, size_t end, std::function<void(int)> function, schedule kind) {
+        parallel_for(start, end, std::move(function), parallel_options { .kind = kind });
+    }
 
-        size_t base = end / thread_count;
-        size_t leftover = end % thread_count;
+    void parallel_for(size_t start, size_t end, std::function<void(int)> function, const parallel_options& options) {
 
-        for (size_t i = 0; i < thread_count; i++) {
+        if (end <= start) return;
 
-            size_t min = start + base * i;
-            size_t max = start + base * (i + 1);
-            if (i == thread_count)
-                max += leftover;
+        auto parts = make_partitioner(start, end, options);
 
-            threads.push_back(std::thread(func, min, max));
-        }
+        parallel_chunks(parts, [&](size_t begin, size_t last, size_t) {
+            for (size_t i = begin; i < last; i++)
+                function((int)i);
+        }, options.stats);
 
-        for (auto &thread : threads)
-            thread.join();
     }
 
 #ifdef THIRD_PARTY
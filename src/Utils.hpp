@@ -5,8 +5,15 @@
 #include <functional>
 #include <optional>
 #include <filesystem>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <vector>
 
 #include "extensions.hpp"
+#include "Trace.hpp"
+#include "Numa.hpp"
+#include "Partition.hpp"
 
 #ifdef THIRD_PARTY
 #include <xxh3.h>
@@ -15,7 +22,7 @@
 
 namespace RozeFoundUtils {
 
-	auto print = [](const auto& ... Args) {
+	inline auto print = [](const auto& ... Args) {
 		((std::cout << Args << ' '), ...) << std::endl;
 	};
 
@@ -28,6 +35,12 @@ namespace RozeFoundUtils {
 	uint32_t get_process_id (std::string_view process_name);
 	std::ptrdiff_t get_module_base (uint32_t process_id = 0, std::string_view module = "");
 
+	// Start address of the module's mapping in the text of a /proc/<pid>/maps file
+	std::ptrdiff_t find_module_base (std::string_view maps, std::string_view module = "");
+
+	bool read_process_memory (uint32_t process_id, std::ptrdiff_t address, std::byte* buffer, std::size_t size);
+	bool read_process_memory (uint32_t process_id, std::span<const std::ptrdiff_t> addresses, std::span<std::byte* const> buffers, std::size_t size);
+
 	template<typename T> concept suitable = requires (T container) { container.size(); };
 	std::ptrdiff_t basic_sigscan(std::ptrdiff_t start, suitable auto signature) {
 
@@ -53,7 +66,7 @@ namespace RozeFoundUtils {
 		return std::array { std::byte(Ts) ... };
 	}
 
-	constexpr auto to_bytes (const std::string_view hex_values) noexcept {
+	inline auto to_bytes (const std::string_view hex_values) noexcept {
 
 		auto bytes = std::vector<std::byte>();
 
@@ -103,11 +116,114 @@ namespace RozeFoundUtils {
 
         void makeTimer(std::string_view name, std::function<void()> func);
 
+        // makeTimer with hardware counter columns, per element too when elements isn't 0
+        void makeProfile(std::string_view name, std::function<void()> func, std::size_t elements = 0);
+
         void write_to_file(std::string_view string,std::filesystem::path filepath);
 
         std::optional<std::string> read_from_file(std::filesystem::path filepath);
 
-        void parallel_for(size_t start, size_t end, std::function<void(int)> function);
+        // Calls function(i) for every i in [start, end)
+        void parallel_for(size_t start, size_t end, std::function<void(int)> function, schedule kind = schedule::even);
+        void parallel_for(size_t start, size_t end, std::function<void(int)> function, const parallel_options& options);
+
+	// Runs every worker of parts on its own thread, the calling thread being worker 0, and
+	// calls function(begin, end, worker) for each chunk the worker gets. Per-worker busy
+	// time goes into stats when it is set.
+	// On machines with more than one NUMA node worker i is pinned to numa::topology::cpu_for(i),
+	// so an even chunk always runs on the same node and memory first touched there stays local
+
+	template<typename F> void parallel_chunks(partitioner& parts, F&& function, run_stats* stats = nullptr) {
+
+		if (parts.size() == 0) return;
+
+		size_t thread_count = parts.workers();
+
+		const auto& topology = numa::topology::system();
+		bool pin = topology.nodes().size() > 1 && thread_count > 1;
+
+		using clock = std::chrono::steady_clock;
+		auto started = clock::now();
+
+		if (stats) *stats = { {}, std::vector<std::chrono::nanoseconds>(thread_count),
+			std::vector<size_t>(thread_count), std::vector<size_t>(thread_count) };
+
+		auto work = [&](size_t worker) {
+			parts.run(worker, [&](size_t begin, size_t end) {
+				SCOPED_ZONE("parallel chunk");
+				if (!stats) {
+					function(begin, end, worker);
+					return;
+				}
+
+				auto start = clock::now();
+				function(begin, end, worker);
+				stats->busy[worker] += clock::now() - start;
+				stats->chunks[worker]++;
+				stats->indices[worker] += end - begin;
+			});
+		};
+
+		// Joined before the wall time is taken
+		struct finish {
+			run_stats* stats;
+			clock::time_point started;
+			~finish() { if (stats) stats->wall = clock::now() - started; }
+		} finished { stats, started };
+
+		std::vector<std::jthread> threads;
+		threads.reserve(thread_count - 1);
+
+		for (size_t i = 1; i < thread_count; i++)
+			threads.emplace_back([&, i] {
+				if (pin) numa::pin_thread(topology.cpu_for(i, thread_count));
+				work(i);
+			});
+
+		std::optional<numa::scoped_pin> pinned;
+		if (pin) pinned.emplace(topology.cpu_for(0, thread_count));
+
+		work(0);
+	}
+
+	// Splits [start, end) into one contiguous chunk per thread and calls
+	// function(begin, end, thread_index) for each, the calling thread takes the first chunk
+
+	template<typename F> void parallel_chunks(size_t start, size_t end, F&& function, size_t thread_count = 0) {
+
+		if (end <= start) return;
+		if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+		partitioner parts(start, end, thread_count);
+		parallel_chunks(parts, function);
+	}
+
+	// Calls function for every element of a sized random access range, e.g. Range or a span
+	template<std::ranges::random_access_range R, typename F> requires std::ranges::sized_range<R>
+	void parallel_for(R&& range, F&& function) {
+
+		auto first = std::ranges::begin(range);
+
+		parallel_chunks(0, std::ranges::size(range), [&](size_t begin, size_t end, size_t) {
+			for (auto it = first + begin, last = first + end; it != last; ++it)
+				function(*it);
+		});
+	}
+
+	// Same with a schedule picked by options, e.g. { .growing = true } for work that gets
+	// more expensive towards the end of the range
+
+	template<std::ranges::random_access_range R, typename F> requires std::ranges::sized_range<R>
+	void parallel_for(R&& range, F&& function, const parallel_options& options) {
+
+		auto first = std::ranges::begin(range);
+		auto parts = make_partitioner(0, std::ranges::size(range), options);
+
+		parallel_chunks(parts, [&](size_t begin, size_t end, size_t) {
+			for (auto it = first + begin, last = first + end; it != last; ++it)
+				function(*it);
+		}, options.stats);
+	}
 
 #ifdef THIRD_PARTY
 
@@ -161,7 +277,7 @@ namespace RozeFoundUtils {
 				*it++ = packedResult >> 8;
 				*it++ = packedResult & 0xff;
 			}
-			*it++ = NULL;
+			*it++ = '\0';
 
 			return it;
 		}
@@ -185,7 +301,7 @@ namespace RozeFoundUtils {
 				*it++ = hexDigits[(ch & 0xf0) >> 4];
 				*it++ = hexDigits[ch & 0x0f];
 			}
-			*it++ = NULL;
+			*it++ = '\0';
 
 			return it;
 		}
@@ -202,7 +318,7 @@ namespace RozeFoundUtils {
 				char shch = detail::hex2int((int)bytes[i + 1]);
 				*it++ = fhch + shch;
 			}
-			*it++ = NULL;
+			*it++ = '\0';
 
 			return it;
 		}
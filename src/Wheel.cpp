@@ -0,0 +1,108 @@
+#include "Wheel.hpp"
+#include "Primes.hpp"
+#include "Factor.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace RozeFoundUtils::primes {
+
+    namespace {
+
+        // 8 lanes of 64 bits, compiled to whatever vector width the target has
+        using lanes = uint64_t __attribute__((vector_size(64)));
+        using mask = int64_t __attribute__((vector_size(64)));
+
+        constexpr std::size_t lane_count = sizeof(lanes) / sizeof(uint64_t);
+
+        bool has_small_factor(uint64_t value) noexcept {
+
+            for (const auto& d : detail::small_divisors)
+                if (value * d.inverse <= d.limit && value != d.prime) return true;
+
+            return false;
+        }
+
+        // Trial division by the compile-time table beats Miller-Rabin until about here,
+        // past it the filter has already done the cheap part of is_prime_u64
+        constexpr uint64_t trial_bound = 1 << 21;
+    }
+
+    wheel_candidates::wheel_candidates(uint64_t from, uint64_t to) noexcept : m_Base(from - from % 210), m_To(to) {
+
+        while (m_Index < detail::wheel_residues.size() && m_Base + detail::wheel_residues[m_Index] < from)
+            m_Index++;
+
+    }
+
+    std::size_t wheel_candidates::next_batch(std::span<uint64_t> out) noexcept {
+
+        std::size_t count = 0;
+
+        while (count < out.size()) {
+
+            if (m_Index == detail::wheel_residues.size()) {
+                m_Index = 0;
+                m_Base += 210;
+            }
+
+            uint64_t value = m_Base + detail::wheel_residues[m_Index];
+            if (value >= m_To || value < m_Base) break;
+
+            out[count++] = value;
+            m_Index++;
+        }
+
+        return count;
+
+    }
+
+    std::size_t filter_small_factors(std::span<uint64_t> values) noexcept {
+
+        std::size_t kept = 0, i = 0;
+
+        for (; i + lane_count <= values.size(); i += lane_count) {
+
+            lanes v;
+            std::memcpy(&v, values.data() + i, sizeof(v));
+
+            mask composite = {};
+            for (const auto& d : detail::small_divisors)
+                composite |= (v * d.inverse <= d.limit) & (v != d.prime);
+
+            // Writes never pass the block being read, so compacting in place is safe
+            for (std::size_t lane = 0; lane < lane_count; lane++)
+                if (!composite[lane]) values[kept++] = v[lane];
+        }
+
+        for (; i < values.size(); i++)
+            if (!has_small_factor(values[i])) values[kept++] = values[i];
+
+        return kept;
+
+    }
+
+    std::vector<uint64_t> primes_between(uint64_t from, uint64_t to) {
+
+        std::vector<uint64_t> result;
+
+        for (uint64_t p : { 2, 3, 5, 7 })
+            if (p >= from && p < to) result.push_back(p);
+
+        auto candidates = wheel_candidates(std::max<uint64_t>(from, 11), to);
+        auto batch = std::array<uint64_t, 1024>();
+
+        while (std::size_t count = candidates.next_batch(batch)) {
+
+            count = filter_small_factors(std::span(batch.data(), count));
+
+            for (std::size_t i = 0; i < count; i++) {
+                uint64_t value = batch[i];
+                if (value < trial_bound ? is_prime(value) : miller_rabin(value)) result.push_back(value);
+            }
+        }
+
+        return result;
+
+    }
+}
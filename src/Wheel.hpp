@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RozeFoundUtils {
+
+	namespace primes {
+
+		namespace detail {
+
+			// The 48 residues modulo 2*3*5*7 that share no factor with it
+			inline constexpr auto wheel_residues = [] {
+
+				std::array<uint8_t, 48> result = {};
+				for (uint32_t n = 0, i = 0; n < 210; n++)
+					if (n % 2 && n % 3 && n % 5 && n % 7) result[i++] = uint8_t(n);
+
+				return result;
+			}();
+
+			// Odd p divides n exactly when n * p^-1 mod 2^64 <= (2^64 - 1) / p,
+			// a multiplication and a compare instead of a division
+
+			struct divisor {
+				uint64_t prime;
+				uint64_t inverse;
+				uint64_t limit;
+			};
+
+			consteval divisor make_divisor(uint64_t p) {
+				uint64_t inverse = p;
+				for (int i = 0; i < 5; i++) inverse *= 2 - p * inverse;
+				return { p, inverse, ~uint64_t(0) / p };
+			}
+
+			// The primes right after the wheel, each strikes out about 1/p of what's left
+			inline constexpr std::array<divisor, 16> small_divisors = {
+				make_divisor(11), make_divisor(13), make_divisor(17), make_divisor(19),
+				make_divisor(23), make_divisor(29), make_divisor(31), make_divisor(37),
+				make_divisor(41), make_divisor(43), make_divisor(47), make_divisor(53),
+				make_divisor(59), make_divisor(61), make_divisor(67), make_divisor(71)
+			};
+		}
+
+		// Numbers in [from, to) coprime to 210 in ascending order, 48 out of every
+		// 210 instead of every integer. Handed out in batches of whatever fits
+
+		class wheel_candidates {
+
+		public:
+
+			// Constructors
+
+			wheel_candidates(uint64_t from, uint64_t to) noexcept;
+
+			// Methods
+
+			// Fills the front of out, 0 once the range is exhausted
+			std::size_t next_batch(std::span<uint64_t> out) noexcept;
+
+		private:
+
+			// Local variables
+
+			uint64_t m_Base;
+			std::size_t m_Index = 0;
+			uint64_t m_To;
+		};
+
+		// Drops every value with a prime factor from 11 to 71 other than the value itself,
+		// 8 values at a time. Survivors keep their order and are moved to the front,
+		// returns how many there are
+		std::size_t filter_small_factors(std::span<uint64_t> values) noexcept;
+
+		// Primes in [from, to): wheel candidates, pre-filtered by filter_small_factors,
+		// and only what survives goes through a full primality test
+		std::vector<uint64_t> primes_between(uint64_t from, uint64_t to);
+	}
+}
@@ -0,0 +1,349 @@
+#include "Writer.hpp"
+#include "Trace.hpp"
+#include "Uring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace RozeFoundUtils::io {
+
+    namespace {
+
+        // Jobs of a group write to one open file back to back, starting at offset
+        struct group {
+            std::filesystem::path path, temporary;
+            std::vector<detail::write_job*> jobs;
+            std::vector<iovec> iovecs;
+            int fd = -1;
+            off_t offset = 0;
+            bool append = false, atomic = false, sync = false;
+            int error = 0;
+            const char* failed = nullptr;
+        };
+
+        // One vectored write, or the sync, of a group
+        struct operation {
+            group* target;
+            std::size_t first, count;
+            off_t offset;
+            std::size_t expected;
+            bool sync;
+        };
+
+        std::atomic<uint64_t> temporaries = 0;
+
+        void fail(group& g, const char* what, int error = errno) {
+            if (!g.error) { g.error = error; g.failed = what; }
+        }
+
+        // Synchronously writes what is left of an operation after its first `done` bytes
+        void finish(const operation& op, std::size_t done) {
+
+            auto& g = *op.target;
+            auto left = std::vector<iovec>(g.iovecs.begin() + op.first, g.iovecs.begin() + op.first + op.count);
+            auto first = left.begin();
+            off_t offset = op.offset;
+
+            while (true) {
+
+                offset += off_t(done);
+                for (; first != left.end() && done >= first->iov_len; ++first) done -= first->iov_len;
+                if (first == left.end()) return;
+
+                first->iov_base = static_cast<char*>(first->iov_base) + done;
+                first->iov_len -= done;
+
+                ssize_t written = pwritev(g.fd, &*first, int(std::min<std::ptrdiff_t>(left.end() - first, IOV_MAX)), offset);
+
+                if (written < 0 && errno == EINTR) written = 0;
+                else if (written <= 0) return fail(g, "write", written < 0 ? errno : EIO);
+
+                done = std::size_t(written);
+            }
+        }
+
+        void run(const operation& op) {
+            if (op.target->error) return;
+            if (!op.sync) finish(op, 0);
+            else if (fdatasync(op.target->fd) < 0) fail(*op.target, "fdatasync");
+        }
+
+        // Runs every operation, all of them in flight at once when there is a ring
+        void execute(std::vector<operation>& operations, uring* ring) {
+
+            if (!ring) {
+                for (auto& op : operations) run(op);
+                return;
+            }
+
+            // Operations in the order their entries were prepared, the first `sent` reached the kernel
+            std::vector<std::size_t> prepared;
+            std::size_t sent = 0;
+            bool broken = false;
+
+            auto reap = [&] {
+                ring->reap([&](uint64_t index, int result) {
+                    auto& op = operations[index];
+                    if (result < 0) fail(*op.target, op.sync ? "fdatasync" : "write", -result);
+                    else if (!op.sync && std::size_t(result) < op.expected) finish(op, std::size_t(result));
+                });
+            };
+
+            // EAGAIN and EBUSY pass once completions free kernel resources. Anything else and the
+            // entries not taken are withdrawn, no entry may outlive operations, and run synchronously
+            auto submit = [&](unsigned wait_for) {
+
+                for (int attempt = 0; attempt < 64; attempt++) {
+
+                    int result = ring->submit(wait_for);
+
+                    if (result >= 0) {
+                        sent += std::size_t(result);
+                        return true;
+                    }
+
+                    if (result != -EAGAIN && result != -EBUSY) break;
+
+                    reap();
+                    std::this_thread::yield();
+                }
+
+                ring->discard();
+                for (; sent < prepared.size(); sent++) run(operations[prepared[sent]]);
+
+                broken = true;
+                return false;
+            };
+
+            for (std::size_t i = 0; i < operations.size(); i++) {
+
+                auto& op = operations[i];
+                if (op.target->error) continue;
+
+                io_uring_sqe* sqe = nullptr;
+                while (!broken && !(sqe = ring->get_sqe()))
+                    if (submit(1)) reap();
+
+                if (broken) {
+                    run(op);
+                    continue;
+                }
+
+                sqe->fd = op.target->fd;
+                sqe->user_data = i;
+
+                if (op.sync) {
+                    sqe->opcode = IORING_OP_FSYNC;
+                    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+                } else {
+                    sqe->opcode = IORING_OP_WRITEV;
+                    sqe->addr = reinterpret_cast<uint64_t>(op.target->iovecs.data() + op.first);
+                    sqe->len = unsigned(op.count);
+                    sqe->off = uint64_t(op.offset);
+                }
+
+                prepared.push_back(i);
+            }
+
+            while (!broken && sent < prepared.size()) submit(0);
+
+            // Whatever the kernel took has to come back before operations goes away
+            while (ring->in_flight()) {
+                if (broken) std::this_thread::yield();
+                else submit(1);
+                reap();
+            }
+        }
+
+        void open(group& g) {
+
+            if (g.append) {
+                g.fd = ::open(g.path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+                if (g.fd >= 0) g.offset = lseek(g.fd, 0, SEEK_END);
+            } else if (g.atomic) {
+                g.temporary = g.path;
+                g.temporary += ".tmp." + std::to_string(getpid()) + "." + std::to_string(temporaries++);
+                g.fd = ::open(g.temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            } else {
+                g.fd = ::open(g.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            }
+
+            if (g.fd < 0) fail(g, "open");
+        }
+
+        void close(group& g) {
+
+            if (g.fd >= 0 && ::close(g.fd) < 0) fail(g, "close");
+
+            if (!g.atomic || g.temporary.empty()) return;
+
+            if (g.error) unlink(g.temporary.c_str());
+            else if (rename(g.temporary.c_str(), g.path.c_str()) < 0) fail(g, "rename");
+        }
+
+        // Groups open at once, a round with more files goes out in windows of this many
+        // so the number of descriptors stays bounded whatever the batch size
+        constexpr std::size_t window = 64;
+
+        // Opens every group, writes them all, syncs the ones asking for it, then completes their futures
+        void process(std::span<group> groups, uring* ring) {
+
+            SCOPED_ZONE("async_writer batch");
+
+            std::vector<operation> writes, syncs;
+
+            for (auto& g : groups) {
+
+                open(g);
+                if (g.error) continue;
+
+                for (auto* job : g.jobs)
+                    if (!job->data.empty()) g.iovecs.push_back({ job->data.data(), job->data.size() });
+
+                // Vectored writes take at most IOV_MAX buffers
+                off_t offset = g.offset;
+                for (std::size_t first = 0; first < g.iovecs.size(); first += IOV_MAX) {
+
+                    std::size_t count = std::min<std::size_t>(IOV_MAX, g.iovecs.size() - first), bytes = 0;
+                    for (std::size_t i = first; i < first + count; i++) bytes += g.iovecs[i].iov_len;
+
+                    writes.push_back({ &g, first, count, offset, bytes, false });
+                    offset += off_t(bytes);
+                }
+
+                if (g.sync) syncs.push_back({ &g, 0, 0, 0, 0, true });
+            }
+
+            execute(writes, ring);
+            execute(syncs, ring);
+
+            for (auto& g : groups) {
+
+                close(g);
+
+                for (auto* job : g.jobs) {
+                    if (!g.error) job->done.set_value();
+                    else job->done.set_exception(std::make_exception_ptr(
+                        std::system_error(g.error, std::system_category(), std::string(g.failed) + " " + g.path.string())));
+                }
+            }
+        }
+
+        // Every path of a round is different, so the windows can go out one after another
+        void process_round(std::vector<group>& groups, uring* ring) {
+            for (std::size_t first = 0; first < groups.size(); first += window)
+                process(std::span(groups).subspan(first, std::min(window, groups.size() - first)), ring);
+        }
+    }
+
+    async_writer::async_writer() : m_Thread([this](std::stop_token token) { run(token); }) {}
+
+    async_writer::~async_writer() {
+        m_Thread.request_stop();
+        m_Thread.join();
+    }
+
+    std::future<void> async_writer::write(std::filesystem::path path, std::string data, write_options options) {
+
+        detail::write_job job { std::move(path), std::move(data), options, {} };
+        auto future = job.done.get_future();
+
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Queue.push_back(std::move(job));
+        }
+
+        m_Wakeup.notify_one();
+        return future;
+
+    }
+
+    void async_writer::wait() {
+
+        std::unique_lock lock(m_Mutex);
+        m_Idle.wait(lock, [&] { return m_Queue.empty() && !m_Busy; });
+
+    }
+
+    void async_writer::run(std::stop_token token) {
+
+        std::unique_ptr<uring> ring;
+        if (uring::supported()) {
+            try { ring = std::make_unique<uring>(64); }
+            catch (const std::system_error&) {}
+        }
+
+        std::vector<detail::write_job> batch;
+
+        while (true) {
+
+            {
+                std::unique_lock lock(m_Mutex);
+
+                m_Busy = false;
+                m_Idle.notify_all();
+
+                // Stopping still drains whatever was queued before
+                if (!m_Wakeup.wait(lock, token, [&] { return !m_Queue.empty(); })) return;
+
+                batch.swap(m_Queue);
+                m_Busy = true;
+            }
+
+            // Appends join the group of the same file, anything else reusing a
+            // file of the round has to wait for the next round to keep the order
+            std::vector<group> groups;
+            std::unordered_map<std::string, std::size_t> by_path;
+            groups.reserve(batch.size());
+
+            for (auto& job : batch) {
+
+                auto same = by_path.find(job.path.native());
+
+                if (same != by_path.end() && job.options.append) {
+                    auto& g = groups[same->second];
+                    g.jobs.push_back(&job);
+                    g.sync |= job.options.sync;
+                    continue;
+                }
+
+                if (same != by_path.end()) {
+                    process_round(groups, ring.get());
+                    groups.clear();
+                    by_path.clear();
+                }
+
+                by_path.emplace(job.path.native(), groups.size());
+
+                auto& g = groups.emplace_back();
+                g.path = job.path;
+                g.jobs.push_back(&job);
+                g.append = job.options.append;
+                g.atomic = job.options.atomic && !job.options.append;
+                g.sync = job.options.sync;
+            }
+
+            process_round(groups, ring.get());
+            batch.clear();
+        }
+
+    }
+
+    std::future<void> write_to_file(std::string data, std::filesystem::path path, write_options options) {
+
+        static async_writer writer;
+        return writer.write(std::move(path), std::move(data), options);
+
+    }
+}
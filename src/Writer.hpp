@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace RozeFoundUtils {
+
+	namespace io {
+
+		struct write_options {
+			bool append = false;	// add to the end of the file instead of replacing it
+			bool atomic = false;	// write a temporary file next to it and rename over, readers never see half a file. Not for appends
+			bool sync = false;		// fdatasync before the future completes
+		};
+
+		namespace detail {
+
+			struct write_job {
+				std::filesystem::path path;
+				std::string data;
+				write_options options;
+				std::promise<void> done;
+			};
+		}
+
+		// Background writer: callers queue whole-file writes and get a future back,
+		// a single thread drains the queue in batches. Appends to the same file in a
+		// batch go out as one vectored write, and the writes of a batch are submitted
+		// together through io_uring, or with pwritev where io_uring is unavailable
+
+		class async_writer {
+
+		public:
+
+			// Constructors
+
+			async_writer();
+			async_writer(const async_writer&) = delete;
+			async_writer& operator=(const async_writer&) = delete;
+
+			// Finishes everything already queued
+			~async_writer();
+
+			// Methods
+
+			// The future throws std::system_error when the write failed
+			std::future<void> write(std::filesystem::path path, std::string data, write_options options = {});
+
+			// Blocks until every write queued so far has completed
+			void wait();
+
+		private:
+
+			// Local methods
+
+			void run(std::stop_token token);
+
+			// Local variables
+
+			std::mutex m_Mutex;
+			std::condition_variable_any m_Wakeup;
+			std::condition_variable m_Idle;
+
+			std::vector<detail::write_job> m_Queue;
+			bool m_Busy = false;
+
+			std::jthread m_Thread;
+		};
+
+		// Queues the write on a process-wide writer
+		std::future<void> write_to_file(std::string data, std::filesystem::path path, write_options options = {});
+	}
+}
@@ -1,83 +1,414 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <concepts>
 #include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <vector>
 
+#include <fmt/format.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace ext {
-	struct join_t {
+	namespace detail {
+
 		template<typename T>
-		std::string operator()(const T& Data) const {
+		concept numeric = std::is_arithmetic_v<T> && !std::same_as<T, bool>
+			&& !std::same_as<T, char> && !std::same_as<T, wchar_t> && !std::same_as<T, char8_t>
+			&& !std::same_as<T, char16_t> && !std::same_as<T, char32_t>;
 
-			std::stringstream ss;
+		// Upper bound of characters std::to_chars may produce for T in its shortest form
 
-			ss << '[';
+		template<numeric T> consteval std::size_t max_chars() {
+			if constexpr (std::is_integral_v<T>) return std::numeric_limits<T>::digits10 + 2;
+			else return std::numeric_limits<T>::max_digits10 + std::numeric_limits<T>::max_exponent10 / 100 + 8;
+		}
 
-			for (size_t i = 0; i < Data.size() - 1; i++)
-				ss << Data[i] << ", ";
+		template<class OutIt> OutIt copy_to(OutIt it, std::string_view string) {
+			return std::copy(string.begin(), string.end(), it);
+		}
 
-			ss << Data.back() << ']';
+		template<class OutIt, typename T> OutIt format_to(OutIt it, const T& value) {
+			if constexpr (numeric<T>) {
+				char buffer[max_chars<T>()];
+				auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+				return std::copy(buffer, end, it);
+			}
+			else return fmt::format_to(it, "{}", value);
+		}
+	}
 
-			return ss.str();
+	struct join_t {
+
+		std::string_view separator = ", ";
+		std::string_view open = "[";
+		std::string_view close = "]";
+
+		template<class OutIt, std::ranges::input_range R>
+		OutIt to(OutIt it, R&& Data) const {
+
+			it = detail::copy_to(it, open);
+
+			bool first = true;
+			for (const auto& value : Data) {
+				if (!first) it = detail::copy_to(it, separator);
+				it = detail::format_to(it, value);
+				first = false;
+			}
+
+			return detail::copy_to(it, close);
+		}
+
+		template<std::ranges::input_range R>
+		std::string operator()(R&& Data) const {
+
+			using value_type = std::ranges::range_value_t<R>;
+
+			std::string result;
+
+			// Numbers from a sized range are written straight into one buffer sized for the worst case
+
+			if constexpr (detail::numeric<value_type> && std::ranges::sized_range<R>) {
+
+				std::size_t count = std::ranges::size(Data);
+				result.resize(open.size() + close.size() + count * (detail::max_chars<value_type>() + separator.size()));
+
+				char* it = result.data();
+				char* const last = result.data() + result.size();
+
+				it = std::copy(open.begin(), open.end(), it);
+
+				bool first = true;
+				for (const value_type value : Data) {
+					if (!first) it = std::copy(separator.begin(), separator.end(), it);
+					it = std::to_chars(it, last, value).ptr;
+					first = false;
+				}
+
+				it = std::copy(close.begin(), close.end(), it);
+				result.resize(it - result.data());
+
+			} else to(std::back_inserter(result), Data);
+
+			return result;
 		}
 	};
 
 	const join_t join = {};
 
-	template<typename T>
-	std::string operator|(const T& Data, join_t f) {
-		return f(Data);
+	constexpr join_t join_with(std::string_view separator, std::string_view open = "[", std::string_view close = "]") {
+		return join_t { separator, open, close };
 	}
 
-	struct split_t {
+	template<std::ranges::input_range T>
+	std::string operator|(T&& Data, const join_t& f) {
+		return f(std::forward<T>(Data));
+	}
 
-		auto operator() (std::string_view string) const {
+	namespace detail {
+
+		// Returns position and length of the next delimiter at or after pos, npos if none left
+
+		inline std::pair<std::size_t, std::size_t> find_delimiter(std::string_view string, std::size_t pos, char delimiter) noexcept {
+			auto found = static_cast<const char*>(std::memchr(string.data() + pos, delimiter, string.size() - pos));
+			return { found ? std::size_t(found - string.data()) : std::string_view::npos, 1 };
+		}
+
+		inline std::pair<std::size_t, std::size_t> find_delimiter(std::string_view string, std::size_t pos, std::string_view delimiter) noexcept {
+			if (delimiter.empty()) return { std::string_view::npos, 0 };
+			return { string.find(delimiter, pos), delimiter.size() };
+		}
+
+		template<std::predicate<char> Predicate>
+		std::pair<std::size_t, std::size_t> find_delimiter(std::string_view string, std::size_t pos, const Predicate& predicate) {
+			auto found = std::find_if(string.begin() + pos, string.end(), predicate);
+			return { found == string.end() ? std::string_view::npos : std::size_t(found - string.begin()), 1 };
+		}
+	}
+
+	template<typename Delimiter>
+	class split_view : public std::ranges::view_interface<split_view<Delimiter>> {
+
+		class iterator {
+
+		public:
+
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using iterator_concept = std::forward_iterator_tag;
+
+			iterator() = default;
+			iterator(const split_view* parent) : m_Parent(parent) { find_next(0); skip_empty(); }
+
+			std::string_view operator*() const noexcept { return m_Parent->m_String.substr(m_Begin, m_End - m_Begin); }
 
-			auto parts = std::vector<std::string_view>();
+			iterator& operator++() { advance(); skip_empty(); return *this; }
+			iterator operator++(int) { auto Tmp = *this; ++*this; return Tmp; }
 
-			for (std::size_t i = 0, word_length = 0; i <= string.size(); i++) {
+			bool operator==(const iterator& other) const noexcept { return m_Done == other.m_Done && (m_Done || m_Begin == other.m_Begin); }
+			bool operator==(std::default_sentinel_t) const noexcept { return m_Done; }
 
-				if (i == string.size() || string.at(i) == ' ') {
-					auto word = string.substr(i - word_length, word_length);
-					parts.push_back(word); word_length = 0;
-				} else word_length++;
+		private:
 
+			void find_next(std::size_t pos) {
+				auto [found, length] = detail::find_delimiter(m_Parent->m_String, pos, m_Parent->m_Delimiter);
+				m_Begin = pos;
+				m_End = found == std::string_view::npos ? m_Parent->m_String.size() : found;
+				m_Next = found == std::string_view::npos ? std::string_view::npos : found + length;
 			}
-			
-			return parts;
 
+			void advance() {
+				if (m_Next == std::string_view::npos) m_Done = true;
+				else find_next(m_Next);
+			}
+
+			void skip_empty() {
+				if (m_Parent->m_SkipEmpty)
+					while (!m_Done && m_Begin == m_End) advance();
+			}
+
+			const split_view* m_Parent = nullptr;
+			std::size_t m_Begin = 0, m_End = 0, m_Next = 0;
+			bool m_Done = false;
+		};
+
+	public:
+
+		split_view() = default;
+		split_view(std::string_view string, Delimiter delimiter, bool skip_empty = false)
+			: m_String(string), m_Delimiter(std::move(delimiter)), m_SkipEmpty(skip_empty) {}
+
+		iterator begin() const { return iterator(this); }
+		std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+	private:
+
+		std::string_view m_String;
+		Delimiter m_Delimiter = {};
+		bool m_SkipEmpty = false;
+	};
+
+	template<typename Delimiter>
+	struct split_with_t {
+
+		Delimiter delimiter;
+		bool skip_empty = false;
+
+		auto operator() (std::string_view string) const {
+			return split_view<Delimiter>(string, delimiter, skip_empty);
 		}
+	};
 
+	struct split_t {
+
+		auto operator() (std::string_view string) const {
+			return split_view<char>(string, ' ');
+		}
+	};
+
+	struct split_by_t {
+
+		auto operator() (char delimiter, bool skip_empty = false) const {
+			return split_with_t<char> { delimiter, skip_empty };
+		}
+
+		auto operator() (std::string_view delimiter, bool skip_empty = false) const {
+			return split_with_t<std::string_view> { delimiter, skip_empty };
+		}
+
+		template<std::predicate<char> Predicate>
+		auto operator() (Predicate predicate, bool skip_empty = false) const {
+			return split_with_t<Predicate> { std::move(predicate), skip_empty };
+		}
 	};
 
 	const split_t split = { };
+	const split_by_t split_by = { };
 
-    template<typename T>
+	template<typename T>
 	auto operator| (T string, split_t f) {
 		return f(string);
 	}
 
-	struct widen_t {
-		std::wstring operator()(std::string_view string) const {
+	template<typename T, typename Delimiter>
+	auto operator| (T string, const split_with_t<Delimiter>& f) {
+		return f(string);
+	}
+
+	namespace utf8 {
+
+		namespace detail {
+
+			// Length of the ASCII run at the start of data
+
+			inline std::size_t ascii_prefix(const unsigned char* data, std::size_t size) noexcept {
+
+				std::size_t i = 0;
+#ifdef __SSE2__
+				for (; i + 16 <= size; i += 16) {
+					auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					if (auto mask = unsigned(_mm_movemask_epi8(chunk)))
+						return i + std::countr_zero(mask);
+				}
+#endif
+				while (i < size && data[i] < 0x80) i++;
+
+				return i;
+			}
+
+			template<typename CharT> CharT* widen_ascii(CharT* out, const unsigned char* data, std::size_t size) noexcept {
+
+				std::size_t i = 0;
+#ifdef __SSE2__
+				const auto zero = _mm_setzero_si128();
+				for (; i + 16 <= size; i += 16, out += 16) {
+
+					auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					auto low = _mm_unpacklo_epi8(chunk, zero), high = _mm_unpackhi_epi8(chunk, zero);
+
+					if constexpr (sizeof(CharT) == 2) {
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out), low);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), high);
+					} else {
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(low, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(low, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(high, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(high, zero));
+					}
+				}
+#endif
+				for (; i < size; i++) *out++ = CharT(data[i]);
+
+				return out;
+			}
+
+			struct sequence {
+				char32_t code_point;
+				std::size_t length;
+			};
+
+			// Decodes one multi-byte sequence, length is 0 for overlong, surrogate, truncated or out of range input
+
+			inline sequence decode(const unsigned char* data, std::size_t size) noexcept {
+
+				const unsigned char lead = data[0];
 
-			std::wstring result;
+				std::size_t length; char32_t code_point;
+				unsigned char low = 0x80, high = 0xBF;
 
-			wchar_t wch;
+				if (lead >= 0xC2 && lead <= 0xDF) { length = 2; code_point = lead & 0x1F; }
+				else if (lead >= 0xE0 && lead <= 0xEF) {
+					length = 3; code_point = lead & 0x0F;
+					if (lead == 0xE0) low = 0xA0;
+					else if (lead == 0xED) high = 0x9F;
+				}
+				else if (lead >= 0xF0 && lead <= 0xF4) {
+					length = 4; code_point = lead & 0x07;
+					if (lead == 0xF0) low = 0x90;
+					else if (lead == 0xF4) high = 0x8F;
+				}
+				else return { 0, 0 };
 
-			for (char ch : string) {
-				size_t len = std::mbtowc(&wch, &ch, 4);
-				result.append(1, wch);
+				if (size < length || data[1] < low || data[1] > high) return { 0, 0 };
+				code_point = (code_point << 6) | (data[1] & 0x3F);
+
+				for (std::size_t i = 2; i < length; i++) {
+					if ((data[i] & 0xC0) != 0x80) return { 0, 0 };
+					code_point = (code_point << 6) | (data[i] & 0x3F);
+				}
+
+				return { code_point, length };
+			}
+		}
+
+		// Exact number of CharT units string decodes to, nullopt if it isn't valid UTF-8
+
+		template<typename CharT> std::optional<std::size_t> length(std::string_view string) noexcept {
+
+			static_assert(sizeof(CharT) == 2 || sizeof(CharT) == 4, "only UTF-16 and UTF-32 targets are supported");
+
+			auto data = reinterpret_cast<const unsigned char*>(string.data());
+			std::size_t size = string.size(), result = 0;
+
+			for (std::size_t i = 0; i < size; ) {
+
+				std::size_t ascii = detail::ascii_prefix(data + i, size - i);
+				i += ascii; result += ascii;
+				if (i == size) break;
+
+				auto [code_point, length] = detail::decode(data + i, size - i);
+				if (length == 0) return std::nullopt;
+
+				i += length;
+				result += (sizeof(CharT) == 2 && code_point >= 0x10000) ? 2 : 1;
+			}
+
+			return result;
+		}
+
+		// Decodes string into out, input must have been validated with length() first
+
+		template<typename CharT> CharT* decode_to(CharT* out, std::string_view string) noexcept {
+
+			auto data = reinterpret_cast<const unsigned char*>(string.data());
+			std::size_t size = string.size();
+
+			for (std::size_t i = 0; i < size; ) {
+
+				std::size_t ascii = detail::ascii_prefix(data + i, size - i);
+				out = detail::widen_ascii(out, data + i, ascii);
+				i += ascii;
+				if (i == size) break;
+
+				auto [code_point, length] = detail::decode(data + i, size - i);
+				i += length;
+
+				if (sizeof(CharT) == 2 && code_point >= 0x10000) {
+					code_point -= 0x10000;
+					*out++ = CharT(0xD800 + (code_point >> 10));
+					*out++ = CharT(0xDC00 + (code_point & 0x3FF));
+				}
+				else *out++ = CharT(code_point);
 			}
 
+			return out;
+		}
+	}
+
+	template<typename CharT = wchar_t>
+	struct widen_t {
+
+		std::basic_string<CharT> operator()(std::string_view string) const {
+
+			auto length = utf8::length<CharT>(string);
+			if (!length) throw std::range_error("widen: invalid UTF-8 sequence");
+
+			std::basic_string<CharT> result;
+			result.resize(*length);
+			utf8::decode_to(result.data(), string);
+
 			return result;
 		}
 	};
 
-	const widen_t widen = {};
+	const widen_t<> widen = {};
+	const widen_t<char16_t> widen_u16 = {};
+	const widen_t<char32_t> widen_u32 = {};
 
-	template<typename T>
-	std::wstring operator|(const T& Data, widen_t f) {
+	template<typename T, typename CharT>
+	std::basic_string<CharT> operator|(const T& Data, widen_t<CharT> f) {
 		return f(Data);
 	}
 }
\ No newline at end of file
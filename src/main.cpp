@@ -1,5 +1,7 @@
 #include "Experiments.hpp"
 #include "Utils.hpp"
+#include "Primes.hpp"
+#include "Wheel.hpp"
 
 #include <ranges>
 #include <algorithm>
@@ -7,41 +9,15 @@
 
 #include <fmt/core.h>
 namespace u = RozeFoundUtils;
-
-constexpr bool is_prime (std::integral auto n) {
-
-	if (n == 2) return true;
-	else if (n <= 1 || ~n & 1)
-		return false;
-
-	for (auto i = 3; i < n / 2; i += 2)
-		if (n % i == 0) return false;
-
-	return true;
-	
-}
-
-constexpr int count_primes (std::size_t range) {
-
-	auto primes = std::vector<bool>(range); primes.flip();
-	primes.at(0) = false; primes.at(1) = false;
-
-	for (auto p = 2; p * p <= range; p++)
-		if (primes[p]) for (auto i = p * p; i < range; i += p)
-			primes.at(i) = false;
-
-	return std::ranges::count(primes, true);
-
-}
+using u::primes::is_prime;
+using u::primes::count_primes;
 
 int main(int argc, char* argv[]) {
 	
 	auto args = std::vector(argv, argv + argc);
 
 	constexpr size_t size = 1000000;
-	auto numbers = std::vector<int>();
-	for (size_t i = 0; i < size; i++) 
-		numbers.push_back(i);
+	auto numbers = Range<int>(size);
 
 	u::makeTimer("Cound Primes", [&]{
 
@@ -57,9 +33,19 @@ int main(int argc, char* argv[]) {
 	u::makeTimer("Cound Primes (parallel)", [&]{
 
 		std::atomic<int> count = 0;
-		
-		u::parallel_for(0, size, [&] (int i) { if (is_prime(i)) count++; });
+		u::run_stats stats;
+
+		// Trial division costs more the larger i gets
+		u::parallel_for(numbers, [&] (int i) { if (is_prime(i)) count++; }, { .growing = true, .stats = &stats });
+
+		fmt::print("Primes in {}: {}\n", size, count);
+		stats.print("Schedule");
+
+	});
+
+	u::makeTimer("Cound Primes (wheel)", [&]{
 
+		auto count = u::primes::primes_between(0, size).size();
 		fmt::print("Primes in {}: {}\n", size, count);
 
 	});